@@ -35,6 +35,8 @@ void Application::Render()
 	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
 	SDL_RenderClear(renderer);
 
+	const Worker::Result& result = m_worker.GetResult();
+
 	const float scale = m_viewport.GetScale();
 	if (scale >= g_gridThresholdScale)
 	{
@@ -48,7 +50,7 @@ void Application::Render()
 		m_viewport.ToScreen(0.0f, 0.0f, p1.x, p1.y);
 
 		SDL_FPoint p2{};
-		m_viewport.ToScreen(static_cast<float>(m_input.m_width), static_cast<float>(m_input.m_height), p2.x, p2.y);
+		m_viewport.ToScreen(static_cast<float>(result.m_input.m_width), static_cast<float>(result.m_input.m_height), p2.x, p2.y);
 
 		const float xMax = static_cast<float>(GetWidth());
 		const float yMax = static_cast<float>(GetHeight());
@@ -58,153 +60,141 @@ void Application::Render()
 		Limit(p2.x, 0, xMax);
 		Limit(p2.y, 0, yMax);
 
-		SDL_SetRenderDrawColor(renderer, 0x16, 0x16, 0x16, 0xFF);
+		m_gridLines.clear();
 
 		for (float x = p1.x; x <= p2.x; x += scale)
-			SDL_RenderDrawLineF(renderer, x, p1.y, x, p2.y);
+			m_gridLines.push_back({ x, p1.y, 1.0f, p2.y - p1.y + 1.0f });
 
 		for (float y = p1.y; y <= p2.y; y += scale)
-			SDL_RenderDrawLineF(renderer, p1.x, y, p2.x, y);
+			m_gridLines.push_back({ p1.x, y, p2.x - p1.x + 1.0f, 1.0f });
+
+		SDL_SetRenderDrawColor(renderer, 0x16, 0x16, 0x16, 0xFF);
+		SDL_RenderFillRectsF(renderer, m_gridLines.data(), static_cast<int>(m_gridLines.size()));
 	}
 
-	if (m_debugView)
+	if (!m_batch.IsValid())
+		BuildBatch();
+
+	if (scale < g_lodThresholdScale)
 	{
-		for (auto& node : m_generator.m_rootNode->Preorder())
-		{
-			if (node.m_left != nullptr || node.m_right != nullptr)
-				continue;
+		if (!m_pyramid.IsValid())
+			m_pyramid.Build(*this, m_batch, result.m_input.m_width, result.m_input.m_height);
 
-			if (node.m_flags & (1 << dg::impl::Cell::Flag::SPARSE_AREA))
-				SDL_SetRenderDrawColor(renderer, 0x50, 0x40, 0x40, 0xFF);
-			else
-				SDL_SetRenderDrawColor(renderer, 0xFF, 0, 0, 0xFF);
+		if (m_pyramid.Render(renderer, m_viewport))
+			return;
+	}
 
-			SDL_FRect rect;
-			m_viewport.RectToScreen(node.m_space, rect);
-			SDL_RenderDrawRectF(renderer, &rect);
-		}
+	m_batch.Render(renderer, m_viewport, GetWidth(), GetHeight());
+}
 
-		for (dg::impl::Room& room : m_generator.m_rooms)
-		{
-			SDL_SetRenderDrawColor(renderer, 0, 0xAA, 0xAA, 0xFF);
-			for (size_t i = room.m_rectBegin; i < room.m_rectEnd; i++)
-			{
-				const dg::Rect& rect = m_output.m_rooms[i];
-				SDL_FRect sdlRect;
+void Application::BuildBatch()
+{
+	Worker::Result& result = m_worker.GetResult();
+	const dg::Output& output = result.m_output;
 
-				m_viewport.RectToScreen(rect, sdlRect);
-				SDL_RenderDrawRectF(renderer, &sdlRect);
-			}
+	m_batch.Clear();
+	m_pyramid.Invalidate();
 
-			SDL_SetRenderDrawColor(renderer, 0x80, 0, 0x80, 0xFF);
-			for (int i = 0; i < 4; i++)
-			{
-				if (room.m_links[i] == &dg::impl::Vertex::s_sentinel)
-					continue;
-
-				SDL_FPoint p1{ room.m_entrances[i].x + 0.5f, room.m_entrances[i].y + 0.5f };
-				SDL_FPoint p2{ room.m_links[i]->m_pos.x + 0.5f, room.m_links[i]->m_pos.y + 0.5f };
+	if (m_debugView)
+	{
+		const dg::impl::Graph& graph = result.m_generator.m_graph;
+		const uint32_t graphSize = static_cast<uint32_t>(graph.Size());
 
-				m_viewport.ToScreen(p1.x, p1.y, p1.x, p1.y);
-				m_viewport.ToScreen(p2.x, p2.y, p2.x, p2.y);
+		for (const bool sparse : { true, false })
+		{
+			if (sparse) m_batch.Begin(Batch::Kind::OUTLINE, { 0x50, 0x40, 0x40, 0xFF });
+			else m_batch.Begin(Batch::Kind::OUTLINE, { 0xFF, 0, 0, 0xFF });
 
-				SDL_RenderDrawLineF(renderer, p1.x, p1.y, p2.x, p2.y);
+			for (auto& node : result.m_generator.m_tree.Preorder())
+			{
+				if (node.IsLeaf() && static_cast<bool>(node.m_flags & (1 << dg::impl::Cell::Flag::SPARSE_AREA)) == sparse)
+					m_batch.AddRect(node.m_space);
 			}
 		}
 
-		SDL_SetRenderDrawColor(renderer, 0x50, 0x50, 0x50, 0xFF);
-		for (dg::impl::Vertex& vertex : m_generator.m_vertices)
+		const std::vector<dg::impl::Room>& rooms = result.m_generator.m_rooms;
+
+		m_batch.Begin(Batch::Kind::OUTLINE, { 0, 0xAA, 0xAA, 0xFF });
+		for (const dg::impl::Room& room : rooms)
 		{
-			SDL_FPoint p1 = { static_cast<float>(vertex.m_pos.x + 0.5f), static_cast<float>(vertex.m_pos.y + 0.5f) };
-			m_viewport.ToScreen(p1.x, p1.y, p1.x, p1.y);
+			for (size_t i = room.m_rectBegin; i < room.m_rectEnd; i++)
+				m_batch.AddRect(output.m_rooms[i]);
+		}
 
-			const int end = (m_input.m_seed & 0b10) + 2;
-			for (int i = m_input.m_seed & 0b10; i < end; i++)
+		m_batch.Begin(Batch::Kind::LINE, { 0x80, 0, 0x80, 0xFF });
+		for (size_t r = 0; r < rooms.size(); r++)
+		{
+			const uint32_t* const links = graph.Links(dg::impl::Graph::FromRoom(r));
+			for (int i = 0; i < 4; i++)
 			{
-				dg::impl::Vertex* const vertex2 = vertex.m_links[i];
-				if (vertex2 == &dg::impl::Vertex::s_sentinel || vertex2->ToRoom() != nullptr)
-					continue;
-
-				SDL_FPoint p2 = { static_cast<float>(vertex2->m_pos.x + 0.5f), static_cast<float>(vertex2->m_pos.y + 0.5f) };
-				m_viewport.ToScreen(p2.x, p2.y, p2.x, p2.y);
-				SDL_RenderDrawLineF(renderer, p1.x, p1.y, p2.x, p2.y);
+				if (links[i] != dg::impl::Graph::s_sentinel)
+					m_batch.AddLine(rooms[r].m_entrances[i], graph.m_pos[links[i]]);
 			}
 		}
 
-		for (dg::impl::Room& room : m_generator.m_rooms)
+		m_batch.Begin(Batch::Kind::LINE, { 0x50, 0x50, 0x50, 0xFF });
+		for (uint32_t vertex = graph.VertexBegin(); vertex < graphSize; vertex++)
 		{
-			SDL_SetRenderDrawColor(renderer, 0, 0xC0, 0, 0xFF);
-			SDL_FRect rect = { static_cast<float>(room.m_pos.x), static_cast<float>(room.m_pos.y), 1, 1 };
+			const uint32_t* const links = graph.Links(vertex);
 
-			m_viewport.RectToScreen(rect, rect);
-			SDL_RenderFillRectF(renderer, &rect);
-
-			SDL_SetRenderDrawColor(renderer, 0x80, 0, 0x80, 0xFF);
-			for (dg::Point& point : room.m_entrances)
+			const int end = (result.m_input.m_seed & 0b10) + 2;
+			for (int i = result.m_input.m_seed & 0b10; i < end; i++)
 			{
-				rect.x = static_cast<float>(point.x);
-				rect.y = static_cast<float>(point.y);
-				rect.w = 1.0f; rect.h = 1.0f;
-
-				m_viewport.RectToScreen(rect, rect);
-				SDL_RenderFillRectF(renderer, &rect);
+				const uint32_t vertex2 = links[i];
+				if (vertex2 != dg::impl::Graph::s_sentinel && !graph.IsRoom(vertex2))
+					m_batch.AddLine(graph.m_pos[vertex], graph.m_pos[vertex2]);
 			}
 		}
 
-		SDL_SetRenderDrawColor(renderer, 0, 0xC0, 0, 0xFF);
-		for (dg::impl::Vertex& vertex : m_generator.m_vertices)
+		m_batch.Begin(Batch::Kind::FILL, { 0, 0xC0, 0, 0xFF });
+		for (size_t r = 0; r < rooms.size(); r++)
+			m_batch.AddCell(graph.m_pos[dg::impl::Graph::FromRoom(r)]);
+
+		m_batch.Begin(Batch::Kind::FILL, { 0x80, 0, 0x80, 0xFF });
+		for (const dg::impl::Room& room : rooms)
+		{
+			for (const dg::Point& point : room.m_entrances)
+				m_batch.AddCell(point);
+		}
+
+		m_batch.Begin(Batch::Kind::FILL, { 0, 0xC0, 0, 0xFF });
+		for (uint32_t vertex = graph.VertexBegin(); vertex < graphSize; vertex++)
 		{
+			const uint32_t* const links = graph.Links(vertex);
+
 			bool notEmpty = false;
-			for (const auto& link : vertex.m_links)
-				notEmpty |= link != &dg::impl::Vertex::s_sentinel;
+			for (int i = 0; i < 4; i++)
+				notEmpty |= links[i] != dg::impl::Graph::s_sentinel;
 
 			if (notEmpty)
-			{
-				SDL_FRect rect = { static_cast<float>(vertex.m_pos.x), static_cast<float>(vertex.m_pos.y), 1, 1 };
-				m_viewport.RectToScreen(rect, rect);
-				SDL_RenderFillRectF(renderer, &rect);
-			}
+				m_batch.AddCell(graph.m_pos[vertex]);
 		}
 	}
 	else
 	{
 		if (m_visRooms)
 		{
-			SDL_SetRenderDrawColor(renderer, 0, 0xAA, 0xAA, 0xFF);
-			for (dg::Rect& room : m_output.m_rooms)
-			{
-				SDL_FRect rect;
-				m_viewport.RectToScreen(room, rect);
-				SDL_RenderDrawRectF(renderer, &rect);
-			}
+			m_batch.Begin(Batch::Kind::OUTLINE, { 0, 0xAA, 0xAA, 0xFF });
+			for (const dg::Rect& room : output.m_rooms)
+				m_batch.AddRect(room);
 		}
 
 		if (m_visPaths)
 		{
-			SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-			for (auto& [origin, offset] : m_output.m_paths)
-			{
-				SDL_FPoint p1 = { origin.x + 0.5f, origin.y + 0.5f };
-				SDL_FPoint p2 = { offset.x + p1.x, offset.y + p1.y };
-
-				m_viewport.ToScreen(p1.x, p1.y, p1.x, p1.y);
-				m_viewport.ToScreen(p2.x, p2.y, p2.x, p2.y);
-
-				SDL_RenderDrawLineF(renderer, p1.x, p1.y, p2.x, p2.y);
-			}
+			m_batch.Begin(Batch::Kind::LINE, { 0xFF, 0xFF, 0xFF, 0xFF });
+			for (const auto& [origin, offset] : output.m_paths)
+				m_batch.AddLine(origin, dg::Point(origin.x + offset.x, origin.y + offset.y));
 		}
 
 		if (m_visEntrances)
 		{
-			SDL_SetRenderDrawColor(renderer, 0x80, 0, 0x80, 0xFF);
-			for (dg::Point& entrance : m_output.m_entrances)
-			{
-				SDL_FRect rect = { static_cast<float>(entrance.x), static_cast<float>(entrance.y), 1, 1 };
-				m_viewport.RectToScreen(rect, rect);
-				SDL_RenderFillRectF(renderer, &rect);
-			}
+			m_batch.Begin(Batch::Kind::FILL, { 0x80, 0, 0x80, 0xFF });
+			for (const dg::Point& entrance : output.m_entrances)
+				m_batch.AddCell(entrance);
 		}
 	}
+
+	m_batch.Validate();
 }
 
 bool Application::Update()
@@ -227,6 +217,13 @@ bool Application::Update()
 		if (sdlEvent.type == SDL_QUIT)
 			return false;
 
+		if (m_worker.IsEvent(sdlEvent))
+		{
+			Receive();
+			pending = SDL_PollEvent(&sdlEvent);
+			continue;
+		}
+
 		if (Widget::s_active != nullptr)
 		{
 			Widget::s_active->HandleEvent(sdlEvent);
@@ -254,6 +251,7 @@ bool Application::Update()
 			case SDLK_d:
 				Schedule(Task::RENDER);
 				m_debugView = !m_debugView;
+				m_batch.Invalidate();
 				break;
 
 			case SDLK_TAB:
@@ -313,30 +311,39 @@ void Application::Generate()
 	m_input.m_width = static_cast<int>(GetWidth() / m_factor);
 	m_input.m_height = static_cast<int>(GetHeight() / m_factor);
 
-	try
-	{
-		if (m_seedMode == SeedMode::INCREMENT) m_input.m_seed++;
-		else if (m_seedMode == SeedMode::RANDOMIZE) m_input.m_seed = m_randomDevice();
+	if (m_seedMode == SeedMode::INCREMENT) m_input.m_seed++;
+	else if (m_seedMode == SeedMode::RANDOMIZE) m_input.m_seed = m_randomDevice();
 
-		m_generator.Generate(&m_input, &m_output);
+	m_worker.Request(m_input);
+}
 
-		const std::string seed = std::to_string(m_input.m_seed);
-		const std::string rooms = std::to_string(m_output.m_rooms.size());
-		const std::string paths = std::to_string(m_output.m_paths.size());
-		const std::string entrances = std::to_string(m_output.m_entrances.size());
+void Application::Receive()
+{
+	if (!m_worker.Swap())
+		return;
+
+	const Worker::Result& result = m_worker.GetResult();
+	const std::string seed = std::to_string(result.m_input.m_seed);
+
+	if (result.m_error.empty())
+	{
+		const std::string rooms = std::to_string(result.m_output.m_rooms.size());
+		const std::string paths = std::to_string(result.m_output.m_paths.size());
+		const std::string entrances = std::to_string(result.m_output.m_entrances.size());
 
 		AccessWidget<Info>().Set("seed: " + seed + ", rooms: " + rooms + ", paths: " + paths + ", entrances: " + entrances);
 
 		if (Warning* warning = GetWidget<Warning>(); warning != nullptr)
 			warning->Set("");
 	}
-	catch (const std::exception& error)
+	else
 	{
-		AccessWidget<Info>().Set("seed: " + std::to_string(m_input.m_seed) + ", rooms: - , paths: - , entrances: - ");
-		AccessWidget<Warning>().Set(error.what());
-
-		m_output = {};
+		AccessWidget<Info>().Set("seed: " + seed + ", rooms: - , paths: - , entrances: - ");
+		AccessWidget<Warning>().Set(result.m_error);
 	}
+
+	m_batch.Invalidate();
+	Schedule(Task::RENDER);
 }
 
 void Application::LoadDefaults()
@@ -362,6 +369,8 @@ void Application::LoadDefaults()
 	m_input.m_generateFewerPaths = g_generateFewerPaths;
 	m_input.m_spaceInterdistance = g_spaceInterdistance;
 	m_input.m_spaceSizeRandomness = g_spaceSizeRandomness;
+	m_input.m_parallelDepth = g_parallelDepth;
+	m_input.m_threadCount = g_threadCount;
 
 	if (Menu* menu = GetWidget<Menu>(); menu != nullptr)
 		menu->ScheduleRendering();
@@ -393,6 +402,7 @@ void Application::SetupWidgets()
 	menu.Add<PercentMod>("Path cost factor", m_input.m_pathCostFactor);
 	menu.Add<IntMod>("Extra path count", m_input.m_extraPathCount);
 	menu.Add<IntMod>("Extra path depth", m_input.m_extraPathDepth);
+	menu.Add<IntMod>("Parallel depth", m_input.m_parallelDepth);
 	menu.Add<BoolMod>("Rooms visibility", m_visRooms);
 	menu.Add<BoolMod>("Paths visibility", m_visPaths);
 	menu.Add<BoolMod>("Entrances visibility", m_visEntrances);
@@ -431,6 +441,8 @@ void Application::Init(bool full)
 
 void Application::Quit(bool full)
 {
+	m_pyramid.Clear();
+
 	if (m_widgetList != nullptr)
 	{
 		delete m_widgetList;
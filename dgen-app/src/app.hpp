@@ -4,11 +4,14 @@
 #pragma once
 #include "anim.hpp"
 #include "appmgr.hpp"
-#include "dgen_impl.hpp"
+#include "batch.hpp"
 #include "global.hpp"
+#include "pyramid.hpp"
 #include "vport.hpp"
+#include "worker.hpp"
 
 #include <random>
+#include <vector>
 
 class Application;
 
@@ -60,8 +63,10 @@ class Application : protected AppManager
 	bool m_fullscreen = false;
 
 	dg::Input m_input;
-	dg::Output m_output;
-	dg::impl::Generator m_generator;
+	Worker m_worker;
+	Batch m_batch;
+	Pyramid m_pyramid;
+	std::vector<SDL_FRect> m_gridLines;
 
 	Viewport m_viewport;
 	std::random_device m_randomDevice;
@@ -74,8 +79,10 @@ class Application : protected AppManager
 
 	void Draw();
 	void Render();
+	void BuildBatch();
 	bool Update();
 	void Generate();
+	void Receive();
 	void LoadDefaults();
 	void SetupWidgets();
 	void RenderWidgets();
@@ -0,0 +1,214 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#include "batch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void Batch::Clear()
+{
+	// Groups are only emptied, so their storage is reused by the next map.
+	for (size_t i = 0; i < m_groupCount; i++)
+	{
+		m_groups[i].m_elements.clear();
+		m_groups[i].m_tiles.clear();
+	}
+
+	m_groupCount = 0;
+	m_valid = false;
+}
+
+void Batch::Validate()
+{
+	float xMin = std::numeric_limits<float>::max();
+	float yMin = std::numeric_limits<float>::max();
+	float xMax = std::numeric_limits<float>::lowest();
+	float yMax = std::numeric_limits<float>::lowest();
+
+	m_extents.clear();
+	for (size_t i = 0; i < m_groupCount; i++)
+	{
+		for (const SDL_FRect& element : m_groups[i].m_elements)
+		{
+			const SDL_FRect bounds = GetBounds(m_groups[i].m_kind, element);
+
+			xMin = std::min(xMin, bounds.x);
+			yMin = std::min(yMin, bounds.y);
+			xMax = std::max(xMax, bounds.x + bounds.w);
+			yMax = std::max(yMax, bounds.y + bounds.h);
+
+			m_extents.push_back(std::max(bounds.w, bounds.h));
+		}
+	}
+
+	m_tileSize = s_minTileSize;
+	m_xOrigin = 0;
+	m_yOrigin = 0;
+	m_xTiles = 0;
+	m_yTiles = 0;
+
+	if (!m_extents.empty())
+	{
+		// Tile fits most elements, so they overlap at most four tiles. Grid is then kept proportional
+		// to the number of elements, since every group stores an offset for each tile.
+		const auto nth = m_extents.begin() + static_cast<std::ptrdiff_t>(static_cast<float>(m_extents.size() - 1) * s_tileCoverage);
+		std::nth_element(m_extents.begin(), nth, m_extents.end());
+
+		while (m_tileSize < *nth)
+			m_tileSize *= 2;
+
+		auto Count = [this](float size) -> size_t { return static_cast<size_t>(size / m_tileSize) + 1; };
+		while (Count(xMax - xMin) * Count(yMax - yMin) > m_extents.size() * s_tilesPerElement)
+			m_tileSize *= 2;
+
+		m_xOrigin = xMin;
+		m_yOrigin = yMin;
+		m_xTiles = static_cast<int>(Count(xMax - xMin));
+		m_yTiles = static_cast<int>(Count(yMax - yMin));
+	}
+
+	for (size_t i = 0; i < m_groupCount; i++)
+		Index(m_groups[i]);
+
+	m_valid = true;
+}
+
+void Batch::Index(Group& group)
+{
+	const size_t tileCount = static_cast<size_t>(m_xTiles) * static_cast<size_t>(m_yTiles);
+	group.m_tiles.assign(tileCount + 1, 0);
+
+	auto GetTile = [this](int x, int y) -> size_t { return static_cast<size_t>(y) * static_cast<size_t>(m_xTiles) + static_cast<size_t>(x); };
+
+	// Counting sort by tile, with a copy of every element in each tile it overlaps.
+	size_t copyCount = 0;
+	for (const SDL_FRect& element : group.m_elements)
+	{
+		const TileRange range = GetTiles(GetBounds(group.m_kind, element));
+		for (int y = range.m_yBegin; y < range.m_yEnd; y++)
+		{
+			for (int x = range.m_xBegin; x < range.m_xEnd; x++)
+				group.m_tiles[GetTile(x, y) + 1]++;
+		}
+
+		copyCount += static_cast<size_t>(range.m_xEnd - range.m_xBegin) * static_cast<size_t>(range.m_yEnd - range.m_yBegin);
+	}
+
+	for (size_t i = 0; i < tileCount; i++)
+		group.m_tiles[i + 1] += group.m_tiles[i];
+
+	m_sorted.resize(copyCount);
+	for (const SDL_FRect& element : group.m_elements)
+	{
+		const TileRange range = GetTiles(GetBounds(group.m_kind, element));
+		for (int y = range.m_yBegin; y < range.m_yEnd; y++)
+		{
+			for (int x = range.m_xBegin; x < range.m_xEnd; x++)
+				m_sorted[group.m_tiles[GetTile(x, y)]++] = element;
+		}
+	}
+
+	// Offsets were advanced to the ends of their tiles, so they are shifted back.
+	for (size_t i = tileCount; i > 0; i--)
+		group.m_tiles[i] = group.m_tiles[i - 1];
+
+	group.m_tiles[0] = 0;
+	group.m_elements.swap(m_sorted);
+}
+
+Batch::TileRange Batch::GetTiles(const SDL_FRect& bounds) const
+{
+	auto Clamp = [this](float pos, int count) -> int { return static_cast<int>(std::clamp(std::floor(pos / m_tileSize), 0.0f, static_cast<float>(count - 1))); };
+
+	return { Clamp(bounds.x - m_xOrigin, m_xTiles), Clamp(bounds.y - m_yOrigin, m_yTiles),
+		Clamp(bounds.x + bounds.w - m_xOrigin, m_xTiles) + 1, Clamp(bounds.y + bounds.h - m_yOrigin, m_yTiles) + 1 };
+}
+
+SDL_FRect Batch::GetBounds(Kind kind, const SDL_FRect& element)
+{
+	if (kind != Kind::LINE)
+		return element;
+
+	// Lines cover the cells at both of their ends.
+	return { std::min(element.x, element.x + element.w), std::min(element.y, element.y + element.h), std::abs(element.w) + 1.0f, std::abs(element.h) + 1.0f };
+}
+
+void Batch::Begin(Kind kind, SDL_Color color)
+{
+	if (m_groupCount == m_groups.size())
+		m_groups.emplace_back();
+
+	Group& group = m_groups[m_groupCount++];
+	group.m_kind = kind;
+	group.m_color = color;
+}
+
+void Batch::Transform(const Group& group, const SDL_FRect& element, const Viewport& viewport)
+{
+	const float scale = viewport.GetScale();
+	const float xOffset = viewport.GetXOffset();
+	const float yOffset = viewport.GetYOffset();
+
+	if (group.m_kind == Kind::LINE)
+	{
+		// Lines join the centers of cells.
+		const float x = (element.x + 0.5f - xOffset) * scale;
+		const float y = (element.y + 0.5f - yOffset) * scale;
+		const float w = element.w * scale;
+		const float h = element.h * scale;
+
+		m_screen.push_back({ std::min(x, x + w), std::min(y, y + h), std::abs(w) + 1.0f, std::abs(h) + 1.0f });
+	}
+	else
+		m_screen.push_back({ (element.x - xOffset) * scale, (element.y - yOffset) * scale, element.w * scale, element.h * scale });
+}
+
+void Batch::Render(SDL_Renderer* renderer, const Viewport& viewport, int width, int height)
+{
+	if (m_xTiles == 0 || m_yTiles == 0)
+		return;
+
+	float xMin, yMin, xMax, yMax;
+	viewport.ToWorld(0.0f, 0.0f, xMin, yMin);
+	viewport.ToWorld(static_cast<float>(width), static_cast<float>(height), xMax, yMax);
+
+	if (xMax < m_xOrigin || yMax < m_yOrigin || xMin > m_xOrigin + m_xTiles * m_tileSize || yMin > m_yOrigin + m_yTiles * m_tileSize)
+		return;
+
+	const TileRange view = GetTiles({ xMin, yMin, xMax - xMin, yMax - yMin });
+
+	for (size_t i = 0; i < m_groupCount; i++)
+	{
+		const Group& group = m_groups[i];
+		m_screen.clear();
+
+		for (int y = view.m_yBegin; y < view.m_yEnd; y++)
+		{
+			for (int x = view.m_xBegin; x < view.m_xEnd; x++)
+			{
+				const size_t tile = static_cast<size_t>(y) * static_cast<size_t>(m_xTiles) + static_cast<size_t>(x);
+				for (size_t j = group.m_tiles[tile]; j < group.m_tiles[tile + 1]; j++)
+				{
+					// Copies in the other visible tiles are skipped, so every element is drawn once.
+					const SDL_FRect& element = group.m_elements[j];
+					const TileRange range = GetTiles(GetBounds(group.m_kind, element));
+
+					if (std::max(range.m_xBegin, view.m_xBegin) == x && std::max(range.m_yBegin, view.m_yBegin) == y)
+						Transform(group, element, viewport);
+				}
+			}
+		}
+
+		if (m_screen.empty())
+			continue;
+
+		const int count = static_cast<int>(m_screen.size());
+		SDL_SetRenderDrawColor(renderer, group.m_color.r, group.m_color.g, group.m_color.b, group.m_color.a);
+
+		if (group.m_kind == Kind::OUTLINE)
+			SDL_RenderDrawRectsF(renderer, m_screen.data(), count);
+		else
+			SDL_RenderFillRectsF(renderer, m_screen.data(), count);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include "dgen/dgen.hpp"
+#include "vport.hpp"
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+class Batch
+{
+	// Elements are kept in world coordinates, in groups of the same kind and color. Rendering only transforms
+	// them to the screen, so each group takes a single draw call. Lines are always horizontal or vertical,
+	// so they are drawn as rectangles one pixel thick.
+	//
+	// Once built, elements of every group are sorted into the tiles of a uniform grid, with a copy in every tile
+	// they overlap. Visible ones are found in a contiguous range per row of tiles, and each is drawn only in the
+	// first visible tile it overlaps. Tiles are as large as most elements, so few of them are copied many times.
+
+public:
+	enum class Kind { OUTLINE, FILL, LINE };
+
+private:
+	struct Group
+	{
+		Kind m_kind;
+		SDL_Color m_color;
+		std::vector<SDL_FRect> m_elements;
+		std::vector<size_t> m_tiles;
+	};
+
+	struct TileRange
+	{
+		int m_xBegin, m_yBegin;
+		int m_xEnd, m_yEnd;
+	};
+
+	static constexpr float s_minTileSize = 16;
+	static constexpr float s_tileCoverage = 0.9f;
+	static constexpr size_t s_tilesPerElement = 4;
+
+	bool m_valid = false;
+	size_t m_groupCount = 0;
+	std::vector<Group> m_groups;
+	std::vector<SDL_FRect> m_screen;
+	std::vector<SDL_FRect> m_sorted;
+	std::vector<float> m_extents;
+
+	float m_xOrigin = 0;
+	float m_yOrigin = 0;
+	float m_tileSize = s_minTileSize;
+	int m_xTiles = 0;
+	int m_yTiles = 0;
+
+	void Index(Group& group);
+	void Transform(const Group& group, const SDL_FRect& element, const Viewport& viewport);
+	TileRange GetTiles(const SDL_FRect& bounds) const;
+	static SDL_FRect GetBounds(Kind kind, const SDL_FRect& element);
+
+public:
+	void Clear();
+	void Validate();
+	void Begin(Kind kind, SDL_Color color);
+	void Render(SDL_Renderer* renderer, const Viewport& viewport, int width, int height);
+
+	void AddRect(const dg::Rect& rect);
+	void AddCell(const dg::Point& cell);
+	void AddLine(const dg::Point& from, const dg::Point& to);
+
+	void Invalidate() { m_valid = false; }
+	bool IsValid() const { return m_valid; }
+};
+
+inline void Batch::AddRect(const dg::Rect& rect)
+{
+	m_groups[m_groupCount - 1].m_elements.push_back({ static_cast<float>(rect.x), static_cast<float>(rect.y), static_cast<float>(rect.w), static_cast<float>(rect.h) });
+}
+
+inline void Batch::AddCell(const dg::Point& cell)
+{
+	m_groups[m_groupCount - 1].m_elements.push_back({ static_cast<float>(cell.x), static_cast<float>(cell.y), 1.0f, 1.0f });
+}
+
+inline void Batch::AddLine(const dg::Point& from, const dg::Point& to)
+{
+	m_groups[m_groupCount - 1].m_elements.push_back({ static_cast<float>(from.x), static_cast<float>(from.y), static_cast<float>(to.x - from.x), static_cast<float>(to.y - from.y) });
+}
\ No newline at end of file
@@ -14,6 +14,8 @@ inline const int g_extraPathCount = 5;
 inline const int g_extraPathDepth = 3;
 inline const int g_sparseAreaDepth = 1;
 inline const int g_spaceInterdistance = 1;
+inline const int g_parallelDepth = 0;
+inline const int g_threadCount = 0;
 
 inline const float g_factor = 1.0f;
 inline const float g_minRoomSize = 0.5f;
@@ -48,6 +50,10 @@ inline const int g_inputXOffset2 = 160;
 
 inline const int g_warningMargin = 20;
 inline const float g_gridThresholdScale = 8.0f;
+inline const float g_lodThresholdScale = 1.0f;
+inline const int g_lodMaxSize = 4096;
+inline const int g_lodMaxScreens = 8;
+inline const int g_lodMinSize = 16;
 
 inline const auto g_menuAnimTime = std::chrono::milliseconds(350);
 inline const auto g_infoAnimTime = std::chrono::milliseconds(100);
@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#include "pyramid.hpp"
+#include "global.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void Pyramid::Clear()
+{
+	m_levels.clear();
+	m_valid = false;
+}
+
+bool Pyramid::AddLevel(const AppManager& manager, Batch& batch, float scale, int width, int height, int maxWidth, int maxHeight)
+{
+	SDL_Renderer* const renderer = manager.GetRenderer();
+
+	// Copy covers the whole previous texture, so the halved level keeps covering the same part of the world.
+	SDL_Texture* source = nullptr;
+	SDL_FRect sourceRect{};
+
+	if (width <= maxWidth && height <= maxHeight && !m_levels.empty() && m_levels.back().m_tiles.size() == 1)
+	{
+		const Tile& prev = m_levels.back().m_tiles.front();
+		source = prev.m_texture.Get();
+		sourceRect = prev.m_rect;
+		SDL_SetTextureScaleMode(source, SDL_ScaleModeLinear);
+	}
+
+	Level level;
+	level.m_scale = scale;
+
+	Viewport viewport;
+	viewport.SetDefaultScale(scale);
+	viewport.Reset();
+
+	for (int y = 0; y < height; y += maxHeight)
+	{
+		for (int x = 0; x < width; x += maxWidth)
+		{
+			const int w = std::min(width - x, maxWidth);
+			const int h = std::min(height - y, maxHeight);
+
+			SDL_Texture* texture = manager.CreateTexture(w, h, false);
+			if (texture == nullptr)
+				return false;
+
+			Tile& tile = level.m_tiles.emplace_back();
+			tile.m_texture.Set(std::move(texture));
+
+			SDL_SetRenderTarget(renderer, tile.m_texture.Get());
+
+			if (source != nullptr)
+			{
+				tile.m_rect = sourceRect;
+				SDL_RenderCopy(renderer, source, nullptr, nullptr);
+			}
+			else
+			{
+				tile.m_rect = { x / scale, y / scale, w / scale, h / scale };
+				viewport.SetOffset(tile.m_rect.x, tile.m_rect.y);
+
+				SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
+				SDL_RenderClear(renderer);
+				batch.Render(renderer, viewport, w, h);
+			}
+		}
+	}
+
+	m_levels.push_back(std::move(level));
+	return true;
+}
+
+void Pyramid::Build(const AppManager& manager, Batch& batch, int width, int height)
+{
+	Clear();
+	m_valid = true;
+
+	if (width <= 0 || height <= 0)
+		return;
+
+	SDL_Renderer* const renderer = manager.GetRenderer();
+	SDL_Texture* const target = SDL_GetRenderTarget(renderer);
+
+	SDL_RendererInfo info{};
+	SDL_GetRendererInfo(renderer, &info);
+
+	const int maxWidth = info.max_texture_width > 0 ? std::min(info.max_texture_width, g_lodMaxSize) : g_lodMaxSize;
+	const int maxHeight = info.max_texture_height > 0 ? std::min(info.max_texture_height, g_lodMaxSize) : g_lodMaxSize;
+
+	const double budget = static_cast<double>(manager.GetWidth()) * manager.GetHeight() * g_lodMaxScreens;
+
+	float scale = g_lodThresholdScale;
+	while (static_cast<double>(width) * height * scale * scale > budget)
+		scale *= 0.5f;
+	int w = static_cast<int>(std::ceil(width * scale));
+	int h = static_cast<int>(std::ceil(height * scale));
+
+	while (AddLevel(manager, batch, scale, w, h, maxWidth, maxHeight) && (w > g_lodMinSize || h > g_lodMinSize))
+	{
+		w = std::max((w + 1) >> 1, 1);
+		h = std::max((h + 1) >> 1, 1);
+		scale *= 0.5f;
+	}
+
+	SDL_SetRenderTarget(renderer, target);
+}
+
+bool Pyramid::Render(SDL_Renderer* renderer, const Viewport& viewport) const
+{
+	const float scale = viewport.GetScale();
+	if (m_levels.empty() || scale >= m_levels.front().m_scale)
+		return false;
+
+	size_t index = 0;
+	while (index + 1 < m_levels.size() && m_levels[index + 1].m_scale >= scale)
+		index++;
+
+	for (const Tile& tile : m_levels[index].m_tiles)
+	{
+		SDL_FRect rect{};
+		viewport.ToScreen(tile.m_rect.x, tile.m_rect.y, rect.x, rect.y);
+
+		rect.w = tile.m_rect.w * scale;
+		rect.h = tile.m_rect.h * scale;
+
+		SDL_SetTextureScaleMode(tile.m_texture.Get(), SDL_ScaleModeLinear);
+		SDL_RenderCopyF(renderer, tile.m_texture.Get(), nullptr, &rect);
+	}
+
+	return true;
+}
\ No newline at end of file
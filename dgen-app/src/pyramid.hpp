@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include "appmgr.hpp"
+#include "batch.hpp"
+#include "texture.hpp"
+#include "vport.hpp"
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+class Pyramid
+{
+	// Map is rasterized at the scale of the first level into tiles no larger than a texture may be. That scale is
+	// g_lodThresholdScale, halved until the level takes at most g_lodMaxScreens times the pixels of the window,
+	// so memory doesn't grow with the map. Closer views are drawn directly, when only a part of the map is visible.
+	// Levels that fit in one texture are the previous one halved with linear filtering, larger ones are rasterized
+	// again. Views zoomed out below the first level copy the smallest level still at least as detailed, so their
+	// cost doesn't depend on the size of the map. If the first level can't be allocated, nothing is cached.
+
+	struct Tile
+	{
+		Texture m_texture;
+		SDL_FRect m_rect{};
+	};
+
+	struct Level
+	{
+		std::vector<Tile> m_tiles;
+		float m_scale = 0;
+	};
+
+	bool m_valid = false;
+	std::vector<Level> m_levels;
+
+	bool AddLevel(const AppManager& manager, Batch& batch, float scale, int width, int height, int maxWidth, int maxHeight);
+
+public:
+	void Clear();
+	void Build(const AppManager& manager, Batch& batch, int width, int height);
+	bool Render(SDL_Renderer* renderer, const Viewport& viewport) const;
+
+	void Invalidate() { m_valid = false; }
+	bool IsValid() const { return m_valid; }
+};
\ No newline at end of file
@@ -44,6 +44,7 @@ public:
 
 	void SetScaleStep(float scaleStep) { m_scaleStep = scaleStep; }
 	void SetDefaultScale(float defScale) { if (defScale != 0) m_defScale = defScale; }
+	void SetOffset(float xOffset, float yOffset) { m_xOffset = xOffset; m_yOffset = yOffset; }
 };
 
 template <typename Type> template <typename WRectType, typename SRectType>
@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#include "worker.hpp"
+#include <stdexcept>
+#include <utility>
+
+Worker::Worker() : m_eventType(SDL_RegisterEvents(1))
+{
+	if (m_eventType == static_cast<Uint32>(-1))
+		throw std::runtime_error("Failed to register the generation event");
+
+	for (Result& result : m_results)
+	{
+		result.m_generator.m_retainState = true;
+		result.m_generator.m_cancellation = &m_token;
+	}
+
+	m_thread = std::thread(&Worker::Loop, this);
+}
+
+Worker::~Worker()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+		m_token.Cancel();
+	}
+
+	m_condition.notify_one();
+	m_thread.join();
+}
+
+void Worker::Loop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		// Back result can't be reused until the completed one is swapped in.
+		m_condition.wait(lock, [this]() -> bool { return m_quit || (m_pending && !m_finished); });
+
+		if (m_quit)
+			return;
+
+		m_back->m_input = m_request;
+		m_pending = false;
+		m_running = true;
+		m_token.Reset();
+
+		lock.unlock();
+
+		bool cancelled = false;
+		try
+		{
+			m_back->m_generator.Generate(&m_back->m_input, &m_back->m_output);
+			m_back->m_error.clear();
+		}
+		catch (const dg::CancelledError&)
+		{
+			cancelled = true;
+		}
+		catch (const std::exception& error)
+		{
+			m_back->m_output = {};
+			m_back->m_error = error.what();
+		}
+
+		lock.lock();
+		m_running = false;
+
+		if (cancelled)
+			continue;
+
+		m_finished = true;
+
+		SDL_Event sdlEvent{};
+		sdlEvent.type = m_eventType;
+		SDL_PushEvent(&sdlEvent);
+	}
+}
+
+bool Worker::Swap()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_finished)
+			return false;
+
+		std::swap(m_front, m_back);
+		m_finished = false;
+	}
+
+	m_condition.notify_one();
+	return true;
+}
+
+void Worker::Request(const dg::Input& input)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_request = input;
+		m_pending = true;
+
+		if (m_running)
+			m_token.Cancel();
+	}
+
+	m_condition.notify_one();
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include "dgen_impl.hpp"
+
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class Worker
+{
+	// Dungeons are generated on a separate thread into the back result, while the front one is displayed.
+	// Request made during generation cancels it, and requests made meanwhile replace each other.
+	// Completed result is announced with an SDL event and swapped in on the thread that handles events.
+
+public:
+	struct Result
+	{
+		dg::Input m_input{};
+		dg::Output m_output;
+		dg::impl::Generator m_generator;
+		std::string m_error;
+	};
+
+private:
+	Result m_results[2];
+	Result* m_front = &m_results[0];
+	Result* m_back = &m_results[1];
+
+	dg::Input m_request{};
+	bool m_pending = false;
+	bool m_running = false;
+	bool m_finished = false;
+	bool m_quit = false;
+
+	dg::CancellationToken m_token;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::thread m_thread;
+
+	Uint32 m_eventType;
+
+	void Loop();
+
+public:
+	Worker();
+	~Worker();
+
+	Worker(const Worker& ref) = delete;
+	Worker& operator=(const Worker& ref) = delete;
+
+	Worker(Worker&& ref) noexcept = delete;
+	Worker& operator=(Worker&& ref) noexcept = delete;
+
+	bool Swap();
+	void Request(const dg::Input& input);
+
+	bool IsEvent(const SDL_Event& sdlEvent) const { return sdlEvent.type == m_eventType; }
+	Result& GetResult() { return *m_front; }
+};
\ No newline at end of file
@@ -51,18 +51,27 @@ void Probe::ComputeHash(const void* data, size_t size)
 	}
 }
 
-void TimedGenerator::TimedGenerate(Probe& probe, const dg::Input* input)
+void TimedGenerator::TimedGenerate(Probe& probe, const Config* config)
 {
 	dg::Output output;
 
+	if (config->m_queuePolicy == "radix")
+		m_queuePolicy = dg::impl::QueuePolicy::RADIX_HEAP;
+	else if (config->m_queuePolicy == "indexed")
+		m_queuePolicy = dg::impl::QueuePolicy::INDEXED_HEAP;
+	else
+		m_queuePolicy = dg::impl::QueuePolicy::BINARY_HEAP;
+
+	m_speculativePaths = config->m_speculativePaths;
+
 	probe.Start();
-	m_input = input;
+	m_input = config;
 	m_output = &output;
 
 	Prepare();
 	probe.Measure("Prepare");
 
-	GenerateTree(*m_rootNode, m_input->m_maxDepth);
+	GenerateTree();
 	probe.Measure("Generate Tree");
 
 	GenerateRooms();
@@ -94,6 +103,9 @@ void Config::Load(ini::section_type& section, bool req)
 	ini::Get(section, "minTime", m_minTime, req);
 	ini::Get(section, "minWarmupIter", m_minWarmupIter, req);
 	ini::Get(section, "minWarmupTime", m_minWarmupTime, req);
+	ini::Get(section, "batchSize", m_batchSize, req, +[](const int& size) { return size > 0; });
+	ini::Get(section, "speculativePaths", m_speculativePaths, req);
+	ini::Get(section, "queuePolicy", m_queuePolicy, req, +[](const std::string& policy) { return policy == "heap" || policy == "radix" || policy == "indexed"; });
 
 	ini::Get(section, "seed", m_seed, req);
 	ini::Get(section, "width", m_width, req);
@@ -113,6 +125,8 @@ void Config::Load(ini::section_type& section, bool req)
 	ini::Get(section, "spaceInterdistance", m_spaceInterdistance, req);
 	ini::Get(section, "generateFewerPaths", m_generateFewerPaths, req);
 	ini::Get(section, "spaceSizeRandomness", m_spaceSizeRandomness, req);
+	ini::Get(section, "parallelDepth", m_parallelDepth, req);
+	ini::Get(section, "threadCount", m_threadCount, req);
 }
 
 void Trial::Interpret(const Probe& probe, std::vector<const char*>& columns, bool measure)
@@ -178,6 +192,58 @@ void Trial::Interpret(const Probe& probe, std::vector<const char*>& columns, boo
 	}
 }
 
+double Trial::GetSpeedup(const Trial& baseline) const
+{
+	return std::chrono::duration<double>(baseline.m_minDuration) / std::chrono::duration<double>(m_minDuration);
+}
+
+bool Trial::HasSameOutput(const Trial& baseline) const
+{
+	return m_hashBehavior == HashBehavior::STEADY && baseline.m_hashBehavior == HashBehavior::STEADY && m_hash == baseline.m_hash;
+}
+
+void BatchTrial::Generate(Probe& probe, bool measure)
+{
+	const size_t batchSize = static_cast<size_t>(m_config.m_batchSize);
+
+	m_seeds.resize(batchSize);
+	m_outputs.resize(batchSize);
+
+	for (size_t i = 0; i < batchSize; i++)
+		m_seeds[i] = m_config.m_seed + i;
+
+	probe.Start();
+	dg::GenerateBatch(&m_config, m_seeds.data(), batchSize, m_outputs.data(), m_config.m_threadCount);
+	probe.Measure("Generate Batch");
+
+	for (const dg::Output& output : m_outputs)
+	{
+		probe.ComputeHash(output.m_rooms.data(), SizeInBytes(output.m_rooms));
+		probe.ComputeHash(output.m_paths.data(), SizeInBytes(output.m_paths));
+		probe.ComputeHash(output.m_entrances.data(), SizeInBytes(output.m_entrances));
+	}
+
+	if (measure)
+	{
+		const duration_type duration = probe.m_timePoints.back().first - probe.m_startTimePoint;
+		if (m_minDuration > duration)
+			m_minDuration = duration;
+
+		m_iterations++;
+	}
+
+	if (m_hashBehavior == HashBehavior::STEADY)
+	{
+		if (m_hash != probe.m_hash)
+			m_hashBehavior = HashBehavior::UNSTEADY;
+	}
+	else if (m_hashBehavior == HashBehavior::UNKNOWN)
+	{
+		m_hash = probe.m_hash;
+		m_hashBehavior = HashBehavior::STEADY;
+	}
+}
+
 void Benchmark::RunTrials()
 {
 	using std::chrono::milliseconds;
@@ -229,7 +295,70 @@ void Benchmark::RunTrials()
 		}
 
 		const auto elapsed = std::chrono::duration_cast<milliseconds>(now - startTime).count();
-		std::cout << "done! (" << elapsed << " ms, " << trial.m_iterations << " i)\n" << std::flush;
+		std::cout << "done! (" << elapsed << " ms, " << trial.m_iterations << " i";
+
+		// Trials which produce different maps run different searches, so their times aren't comparable.
+		if (const Trial* baseline = FindTrial(trial.m_baseline))
+		{
+			if (trial.HasSameOutput(*baseline))
+				std::cout << ", " << trial.GetSpeedup(*baseline) << "x";
+			else
+				std::cout << ", different output";
+		}
+
+		std::cout << ")\n" << std::flush;
+	}
+
+	std::cout << '\n';
+}
+
+void Benchmark::RunBatchTrials()
+{
+	using std::chrono::milliseconds;
+
+	if (m_batchTrials.empty())
+		return;
+
+	std::cout << " ************ BATCH GENERATION ************\n\n";
+
+	Probe probe;
+	unsigned int index = 1;
+
+	for (BatchTrial& trial : m_batchTrials)
+	{
+		std::cout << ' ' << index++ << '/' << m_batchTrials.size() << ' ' << trial.m_name << std::flush;
+
+		bool measure = false;
+		int remIter = trial.m_config.m_minWarmupIter;
+
+		time_type now;
+		time_type startTime = clock_type::now();
+		duration_type minDuration = milliseconds(trial.m_config.m_minWarmupTime);
+
+		while (true)
+		{
+			trial.Generate(probe, measure);
+
+			remIter--;
+			now = clock_type::now();
+
+			if (remIter > 0 || minDuration > now - startTime)
+				continue;
+
+			if (measure)
+				break;
+
+			measure = true;
+			remIter = trial.m_config.m_minIter;
+
+			startTime = now;
+			minDuration = milliseconds(trial.m_config.m_minTime);
+
+			std::cout << "... " << std::flush;
+		}
+
+		const double seconds = std::chrono::duration<double>(trial.m_minDuration).count();
+		std::cout << "done! (" << trial.m_config.m_batchSize / seconds << " maps/s, " << trial.m_iterations << " i)\n" << std::flush;
 	}
 
 	std::cout << '\n';
@@ -260,6 +389,27 @@ void Benchmark::LoadConfig()
 
 		trial.m_config.Load(crrSection, false);
 		ini::Get(crrSection, "name", trial.m_name, false);
+
+		// Speedup is measured against one of the earlier trials, since they are run in order.
+		ini::Get(crrSection, "baseline", trial.m_baseline, false);
+
+		if (!trial.m_baseline.empty() && FindTrial(trial.m_baseline) == &trial)
+			throw std::runtime_error("Baseline of " + trial.m_name + " wasn't found among the earlier trials");
+	}
+
+	for (unsigned int i = 0; true; i++)
+	{
+		const std::string name = "batch_" + std::to_string(i);
+		const auto iter = container.find(name);
+
+		if (iter == container.end())
+			break;
+
+		ini::section_type& crrSection = iter->second;
+		BatchTrial& trial = m_batchTrials.emplace_back(globalConfig, name);
+
+		trial.m_config.Load(crrSection, false);
+		ini::Get(crrSection, "name", trial.m_name, false);
 	}
 }
 
@@ -276,7 +426,7 @@ void Benchmark::SaveSummary() const
 
 	for (const char* column : m_columns)
 		file << ',' << column;
-	file << ",Min Total Time,Iterations,Hash\n";
+	file << ",Min Total Time,Iterations,Speedup,Hash\n";
 
 	for (const Trial& trial : m_trials)
 	{
@@ -290,6 +440,16 @@ void Benchmark::SaveSummary() const
 			file << ',' << durations.m_min.count();
 		file << ',' << trial.m_minDuration.count() << ',' << trial.m_iterations << ',';
 
+		if (const Trial* baseline = FindTrial(trial.m_baseline))
+		{
+			if (trial.HasSameOutput(*baseline))
+				file << trial.GetSpeedup(*baseline);
+			else
+				file << "Different output";
+		}
+
+		file << ',';
+
 		switch (trial.m_hashBehavior)
 		{
 		case HashBehavior::STEADY:
@@ -308,11 +468,58 @@ void Benchmark::SaveSummary() const
 
 		file << '\n';
 	}
+
+	if (m_batchTrials.empty())
+		return;
+
+	file << "\nName,Threads,Batch Size,Min Batch Time,Maps Per Second,Iterations,Hash\n";
+
+	for (const BatchTrial& trial : m_batchTrials)
+	{
+		const double seconds = std::chrono::duration<double>(trial.m_minDuration).count();
+
+		file << trial.m_name << ',' << dg::impl::ThreadPool::GetThreadCount(trial.m_config.m_threadCount) << ',';
+		file << trial.m_config.m_batchSize << ',' << trial.m_minDuration.count() << ',';
+		file << trial.m_config.m_batchSize / seconds << ',' << trial.m_iterations << ',';
+
+		switch (trial.m_hashBehavior)
+		{
+		case HashBehavior::STEADY:
+			file << std::hex << std::uppercase;
+			file << trial.m_hash;
+			file << std::dec << std::nouppercase;
+			break;
+
+		case HashBehavior::UNSTEADY:
+			file << "Unsteady";
+			break;
+
+		default:
+			file << "Unknown";
+		}
+
+		file << '\n';
+	}
+}
+
+const Trial* Benchmark::FindTrial(const std::string& name) const
+{
+	if (name.empty())
+		return nullptr;
+
+	for (const Trial& trial : m_trials)
+	{
+		if (trial.m_name == name)
+			return &trial;
+	}
+
+	return nullptr;
 }
 
 void Benchmark::Run()
 {
 	LoadConfig();
 	RunTrials();
+	RunBatchTrials();
 	SaveSummary();
 }
\ No newline at end of file
@@ -30,12 +30,7 @@ public:
 	void ComputeHash(const void* data, size_t size);
 
 	friend class Trial;
-};
-
-class TimedGenerator : protected dg::impl::Generator
-{
-public:
-	void TimedGenerate(Probe& probe, const dg::Input* input);
+	friend class BatchTrial;
 };
 
 class Config : public dg::Input
@@ -45,10 +40,19 @@ public:
 	int m_minTime;
 	int m_minWarmupIter;
 	int m_minWarmupTime;
+	int m_batchSize;
+	bool m_speculativePaths;
+	std::string m_queuePolicy;
 
 	void Load(ini::section_type& section, bool req);
 };
 
+class TimedGenerator : protected dg::impl::Generator
+{
+public:
+	void TimedGenerate(Probe& probe, const Config* config);
+};
+
 class Trial
 {
 	struct Durations
@@ -59,6 +63,7 @@ class Trial
 
 	Config m_config;
 	std::string m_name;
+	std::string m_baseline;
 
 	size_t m_iterations = 0;
 	hash_type m_hash = g_initialHash;
@@ -71,6 +76,28 @@ class Trial
 public:
 	Trial(const Config& config, const std::string& name) : m_config(config), m_name(name) {}
 	void Interpret(const Probe& probe, std::vector<const char*>& columns, bool measure);
+	double GetSpeedup(const Trial& baseline) const;
+	bool HasSameOutput(const Trial& baseline) const;
+
+	friend class Benchmark;
+};
+
+class BatchTrial
+{
+	Config m_config;
+	std::string m_name;
+
+	size_t m_iterations = 0;
+	hash_type m_hash = g_initialHash;
+	HashBehavior m_hashBehavior = HashBehavior::UNKNOWN;
+	duration_type m_minDuration = duration_type::max();
+
+	std::vector<uint64_t> m_seeds;
+	std::vector<dg::Output> m_outputs;
+
+public:
+	BatchTrial(const Config& config, const std::string& name) : m_config(config), m_name(name) {}
+	void Generate(Probe& probe, bool measure);
 
 	friend class Benchmark;
 };
@@ -81,11 +108,14 @@ class Benchmark
 
 	std::string m_outputFile;
 	std::vector<Trial> m_trials;
+	std::vector<BatchTrial> m_batchTrials;
 	std::vector<const char*> m_columns;
 
 	void RunTrials();
+	void RunBatchTrials();
 	void LoadConfig();
 	void SaveSummary() const;
+	const Trial* FindTrial(const std::string& name) const;
 
 public:
 	void Run();
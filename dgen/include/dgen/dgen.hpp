@@ -12,12 +12,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <iosfwd>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
 namespace dg
 {
+	namespace impl
+	{
+		struct Cache;
+		struct Generator;
+		struct World;
+	}
+
 	struct Point
 	{
 		int x, y;
@@ -92,6 +104,12 @@ namespace dg
 
 		/// @brief If true, generator may produce fewer paths without altering the effective geometry.
 		bool m_generateFewerPaths;
+
+		/// @brief Non-negative integer. If positive, subtrees from this depth are generated in parallel, each with its own random stream.
+		int m_parallelDepth;
+
+		/// @brief Non-negative integer. Maximum number of threads used by the generator. Zero means all available. Doesn't affect the output.
+		int m_threadCount;
 	};
 
 	/// @brief Structure containing the output data of the generator.
@@ -107,12 +125,249 @@ namespace dg
 		std::vector<std::pair<Point, Vec>> m_paths;
 	};
 
+	/// @brief Read-only view of a dungeon stored in the mappable layout. It points into the stored data and doesn't own any memory.
+	struct OutputView
+	{
+		/// @brief Input the dungeon was generated from. Its thread count is always zero, since it doesn't affect the output.
+		Input m_input;
+
+		/// @brief Rooms of the dungeon, as in @ref Output::m_rooms.
+		const Rect* m_rooms;
+		std::size_t m_roomCount;
+
+		/// @brief Entrances of the dungeon, as in @ref Output::m_entrances.
+		const Point* m_entrances;
+		std::size_t m_entranceCount;
+
+		/// @brief Paths of the dungeon, as in @ref Output::m_paths.
+		const std::pair<Point, Vec>* m_paths;
+		std::size_t m_pathCount;
+	};
+
+	/// @brief Flag which cancels the generation using it. It can be set from any thread.
+	class CancellationToken
+	{
+		std::atomic<bool> m_cancelled{ false };
+
+	public:
+		/// @brief Requests cancellation of the generation using this token.
+		void Cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+		/// @brief Withdraws the request, so the token can be used again.
+		void Reset() { m_cancelled.store(false, std::memory_order_relaxed); }
+
+		/// @brief Checks if the cancellation was requested.
+		bool IsCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+	};
+
+	/// @brief Exception thrown by a cancelled generation. Output is left empty and the memory of the generator is released.
+	class CancelledError : public std::runtime_error
+	{
+	public:
+		CancelledError() : std::runtime_error("Generation was cancelled") {}
+	};
+
+	/// @brief Function called during generation with an estimate of the work done, in range [0, 1], and the data given along with it.
+	/// It's called on the thread which generates the dungeon. Returning false cancels the generation.
+	using ProgressCallback = bool (*)(float progress, void* data);
+
 	/// @brief Function returns example input data, useful for testing.
 	/// @return Object that holds input data for the generator.
 	Input GetExampleInput();
 
+	/// @brief Object that keeps the internal state of the generator between calls.
+	/// Reusing one context for many dungeons avoids reallocating internal buffers every time.
+	class Context
+	{
+		impl::Generator* m_generator;
+
+		impl::Generator& Access();
+
+	public:
+		Context();
+		~Context();
+
+		Context(const Context& ref) = delete;
+		Context& operator=(const Context& ref) = delete;
+
+		Context(Context&& ref) noexcept;
+		Context& operator=(Context&& ref) noexcept;
+
+		/// @brief Generates a dungeon, reusing memory allocated during previous calls.
+		/// If only m_heuristicFactor, m_pathCostFactor, m_extraPathCount, m_generateFewerPaths or m_threadCount changed
+		/// since the previous call, rooms and vertices are reused and only the paths are generated again.
+		/// @param input Pointer to existing Input structure, already containing input information.
+		/// @param output Pointer to existing Output structure. Its previous content is discarded, but its storage is reused.
+		void Generate(const Input* input, Output* output);
+
+		/// @brief Frees all memory retained by the context.
+		void Release();
+
+		/// @brief Sets the token checked between stages and periodically inside the longest ones. Cancelled generation throws @ref CancelledError.
+		/// @param token Pointer to existing token, which must outlive its use by the context. Null pointer disables cancellation.
+		void SetCancellationToken(const CancellationToken* token);
+
+		/// @brief Sets the callback called between stages and periodically inside the longest ones.
+		/// @param callback Function receiving the progress. Null pointer disables progress reporting.
+		/// @param data Pointer passed to every call of the callback.
+		void SetProgressCallback(ProgressCallback callback, void* data = nullptr);
+
+		/// @brief Enables searching paths of large maps speculatively on many threads. Output stays the same, but most speculative
+		/// searches conflict and run again, so it takes several times the CPU time for a small speedup. Disabled by default.
+		/// @param enabled True to search paths in parallel when @ref Input::m_threadCount allows more than one thread.
+		void SetSpeculativePaths(bool enabled);
+	};
+
+	/// @brief Counters of the lookups made by a Cache.
+	struct CacheStats
+	{
+		/// @brief Number of dungeons copied from memory.
+		std::size_t m_memoryHits;
+
+		/// @brief Number of dungeons loaded from disk.
+		std::size_t m_diskHits;
+
+		/// @brief Number of dungeons which had to be generated.
+		std::size_t m_misses;
+	};
+
+	/// @brief Object that remembers generated dungeons by the hash of their input, so the same dungeon is never generated twice.
+	/// Recently used dungeons are kept in memory, and optionally all of them are stored on disk in the compact binary format.
+	class Cache
+	{
+		impl::Cache* m_cache;
+
+	public:
+		/// @brief Creates an empty cache.
+		/// @param capacity Maximum number of dungeons kept in memory. Zero disables the memory tier.
+		/// @param directory Existing directory for the disk tier. Empty string disables it. Failures of the disk tier only cause misses.
+		Cache(std::size_t capacity, const std::string& directory = std::string());
+		~Cache();
+
+		Cache(const Cache& ref) = delete;
+		Cache& operator=(const Cache& ref) = delete;
+
+		Cache(Cache&& ref) noexcept;
+		Cache& operator=(Cache&& ref) noexcept;
+
+		/// @brief Copies the cached dungeon into the output, or generates and caches it if it isn't known yet.
+		/// @param input Pointer to existing Input structure, already containing input information.
+		/// @param output Pointer to existing Output structure. Its previous content is discarded, but its storage is reused.
+		void Generate(const Input* input, Output* output);
+
+		/// @brief Returns the counters of all lookups made so far.
+		CacheStats GetStats() const;
+
+		/// @brief Drops all dungeons kept in memory and frees memory of the generator. Disk tier is left intact.
+		void Clear();
+	};
+
+	/// @brief Object that generates an unbounded world as a grid of chunks. Every chunk is a separate dungeon generated from its own seed,
+	/// so memory use depends only on the size of a chunk. Neighbouring chunks are joined by corridors through gates at their common edges.
+	/// Positions of gates depend only on the world seed, so chunks can be generated lazily and in any order.
+	class World
+	{
+		impl::World* m_world;
+
+	public:
+		/// @brief Creates a world without generating any chunks.
+		/// @param input Pointer to existing Input structure. It describes every chunk, and its seed identifies the whole world.
+		/// @param capacity Maximum number of chunks kept in memory. At least one chunk is always kept.
+		World(const Input* input, std::size_t capacity);
+		~World();
+
+		World(const World& ref) = delete;
+		World& operator=(const World& ref) = delete;
+
+		World(World&& ref) noexcept;
+		World& operator=(World&& ref) noexcept;
+
+		/// @brief Returns the chunk, generating it if it isn't kept in memory. Coordinates in the chunk are relative to its origin,
+		/// which lies at (x * width, y * height) in the world. Chunk includes the corridors to its gates, and the steps over its eastern and southern edges.
+		/// @param x Horizontal index of the chunk.
+		/// @param y Vertical index of the chunk.
+		/// @return Reference to the chunk, valid until the next call on this world.
+		const Output& GetChunk(std::int64_t x, std::int64_t y);
+
+		/// @brief Generates the chunk like @ref GetChunk, but into the given output and without keeping it in memory.
+		/// @param x Horizontal index of the chunk.
+		/// @param y Vertical index of the chunk.
+		/// @param output Pointer to existing Output structure. Its previous content is discarded, but its storage is reused.
+		void GenerateChunk(std::int64_t x, std::int64_t y, Output* output);
+
+		/// @brief Collects the part of the world inside the region, generating only the chunks it touches. Output holds the rooms, entrances
+		/// and paths of these chunks which intersect the region, in the order of chunks and then of their elements, moved so that the region begins at the origin.
+		/// @param x Horizontal world coordinate of the region.
+		/// @param y Vertical world coordinate of the region.
+		/// @param width Width of the region.
+		/// @param height Height of the region.
+		/// @param output Pointer to existing Output structure. Its previous content is discarded, but its storage is reused.
+		void GenerateRegion(std::int64_t x, std::int64_t y, int width, int height, Output* output);
+	};
+
+	/// @brief Computes a 64-bit hash of all Input fields which affect the output. Hash is the same on every platform,
+	/// and it ignores @ref Input::m_threadCount, since the output doesn't depend on it.
+	/// @param input Pointer to existing Input structure.
+	/// @return Hash of the input.
+	std::uint64_t HashInput(const Input* input);
+
 	/// @brief Generates a dungeon.
 	/// @param input Pointer to existing Input structure, already containing input information.
 	/// @param output Pointer to existing Output structure. Generated data about dungeon will be stored inside.
 	void Generate(const Input* input, Output* output);
+
+	/// @brief Generates many dungeons which differ only by their seeds. Each worker thread keeps one generator for all dungeons it takes.
+	/// Dungeons are generated one per thread, so every output is the same as the one Generate would produce for its seed.
+	/// @param input Pointer to existing Input structure, shared by all dungeons. Its seed and thread count are ignored.
+	/// @param seeds Pointer to the array of seeds, one for each dungeon.
+	/// @param count Number of dungeons to generate.
+	/// @param outputs Pointer to the array of count Output structures. Output at index i receives the dungeon generated from seeds[i].
+	/// @param threadCount Non-negative integer. Maximum number of worker threads. Zero means all available.
+	void GenerateBatch(const Input* input, const std::uint64_t* seeds, std::size_t count, Output* outputs, int threadCount);
+
+	/// @brief Appends the dungeon to the buffer in the compact binary format.
+	/// @param output Pointer to existing Output structure, already containing the dungeon.
+	/// @param buffer Pointer to existing vector. Its previous content is kept.
+	void SaveOutput(const Output* output, std::vector<std::uint8_t>* buffer);
+
+	/// @brief Writes the dungeon to the stream in the compact binary format.
+	/// @param output Pointer to existing Output structure, already containing the dungeon.
+	/// @param stream Binary stream, which receives the dungeon at its current position.
+	void SaveOutput(const Output* output, std::ostream& stream);
+
+	/// @brief Reads the dungeon stored in the compact binary format. Throws if the data is truncated, of an unknown version, or corrupted, which is detected by the CRC-32 stored after the dungeon.
+	/// @param data Pointer to the beginning of the stored dungeon.
+	/// @param size Number of bytes available under data. Bytes after the dungeon are ignored.
+	/// @param output Pointer to existing Output structure. Its previous content is discarded, but its storage is reused.
+	/// @return Number of bytes taken by the dungeon.
+	std::size_t LoadOutput(const std::uint8_t* data, std::size_t size, Output* output);
+
+	/// @brief Reads the dungeon stored in the compact binary format. Throws if the data is truncated, of an unknown version, or corrupted, which is detected by the CRC-32 stored after the dungeon.
+	/// @param stream Binary stream positioned at the beginning of the stored dungeon. It's left right after the dungeon.
+	/// @param output Pointer to existing Output structure. Its previous content is discarded, but its storage is reused.
+	void LoadOutput(std::istream& stream, Output* output);
+
+	/// @brief Computes the number of bytes taken by the dungeon in the mappable layout.
+	/// @param output Pointer to existing Output structure, already containing the dungeon.
+	/// @return Size of the layout in bytes.
+	std::size_t GetOutputLayoutSize(const Output* output);
+
+	/// @brief Stores the input and the dungeon in the mappable layout, which can be used in place by @ref ViewOutput.
+	/// @param input Pointer to existing Input structure, which the dungeon was generated from.
+	/// @param output Pointer to existing Output structure, already containing the dungeon.
+	/// @param buffer Pointer to existing vector. Its previous content is discarded.
+	void SaveOutputLayout(const Input* input, const Output* output, std::vector<std::uint8_t>* buffer);
+
+	/// @brief Writes the input and the dungeon to the stream in the mappable layout. A file holding only this data can be mapped and passed to @ref ViewOutput.
+	/// @param input Pointer to existing Input structure, which the dungeon was generated from.
+	/// @param output Pointer to existing Output structure, already containing the dungeon.
+	/// @param stream Binary stream, which receives the layout at its current position.
+	void SaveOutputLayout(const Input* input, const Output* output, std::ostream& stream);
+
+	/// @brief Creates a view of the dungeon stored in the mappable layout without copying it. Throws if the data is truncated,
+	/// misaligned, or was written by an unknown version or on a platform with a different memory layout.
+	/// @param data Pointer to the beginning of the layout, aligned at least like int, e.g. the address of a mapped file.
+	/// @param size Number of bytes available under data.
+	/// @return View pointing into data, valid as long as data is.
+	OutputView ViewOutput(const void* data, std::size_t size);
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <stddef.h>
+
+namespace dg::impl
+{
+	template <typename Type>
+	class Arena
+	{
+		static_assert(std::is_trivially_destructible_v<Type>);
+
+		Type* m_data = nullptr;
+		size_t m_size = 0;
+		size_t m_capacity = 0;
+
+	public:
+		Arena() = default;
+		~Arena() { Reset(); }
+
+		Arena(const Arena& ref);
+		auto operator=(const Arena& ref) -> Arena&;
+
+		Arena(Arena&& ref) noexcept;
+		auto operator=(Arena&& ref) noexcept -> Arena&;
+
+		void Clear() { m_size = 0; }
+		void Reset();
+		void Reserve(size_t newCapacity);
+
+		template <typename... Args>
+		Type* Allocate(size_t count, Args&&... args);
+		Type* Append(const Type* source, size_t count);
+
+		size_t Size() const { return m_size; }
+		size_t Capacity() const { return m_capacity; }
+		Type* Data() const { return m_data; }
+	};
+
+	template <typename Type>
+	Arena<Type>::Arena(const Arena& ref) : m_size(ref.m_size), m_capacity(ref.m_size)
+	{
+		if (ref.m_size > 0)
+		{
+			m_data = static_cast<Type*>(operator new[](sizeof(Type) * ref.m_size));
+
+			for (size_t i = 0; i < ref.m_size; i++)
+				new(m_data + i) Type(ref.m_data[i]);
+		}
+	}
+
+	template <typename Type>
+	auto Arena<Type>::operator=(const Arena& ref) -> Arena&
+	{
+		if (&ref == this)
+			return *this;
+
+		Reset();
+		if (ref.m_size > 0)
+		{
+			m_data = static_cast<Type*>(operator new[](sizeof(Type) * ref.m_size));
+			m_size = ref.m_size;
+			m_capacity = ref.m_size;
+
+			for (size_t i = 0; i < ref.m_size; i++)
+				new(m_data + i) Type(ref.m_data[i]);
+		}
+
+		return *this;
+	}
+
+	template <typename Type>
+	Arena<Type>::Arena(Arena&& ref) noexcept
+		: m_data(std::exchange(ref.m_data, nullptr)), m_size(std::exchange(ref.m_size, 0)), m_capacity(std::exchange(ref.m_capacity, 0)) {}
+
+	template <typename Type>
+	auto Arena<Type>::operator=(Arena&& ref) noexcept -> Arena&
+	{
+		if (&ref == this)
+			return *this;
+
+		Reset();
+
+		m_data = std::exchange(ref.m_data, nullptr);
+		m_size = std::exchange(ref.m_size, 0);
+		m_capacity = std::exchange(ref.m_capacity, 0);
+
+		return *this;
+	}
+
+	template <typename Type>
+	void Arena<Type>::Reset()
+	{
+		operator delete[](m_data);
+
+		m_data = nullptr;
+		m_size = 0;
+		m_capacity = 0;
+	}
+
+	template <typename Type>
+	void Arena<Type>::Reserve(size_t newCapacity)
+	{
+		if (m_size > 0)
+			throw std::logic_error("Cannot reserve memory for a non-empty arena");
+
+		if (newCapacity <= m_capacity)
+			return;
+
+		Reset();
+
+		m_data = static_cast<Type*>(operator new[](sizeof(Type) * newCapacity));
+		m_capacity = newCapacity;
+	}
+
+	template <typename Type> template <typename... Args>
+	Type* Arena<Type>::Allocate(size_t count, Args&&... args)
+	{
+		if (m_capacity - m_size < count)
+			throw std::length_error("Arena capacity exceeded");
+
+		Type* const ptr = m_data + m_size;
+		m_size += count;
+
+		for (size_t i = 0; i < count; i++)
+			new(ptr + i) Type(args...);
+
+		return ptr;
+	}
+
+	template <typename Type>
+	Type* Arena<Type>::Append(const Type* source, size_t count)
+	{
+		if (m_capacity - m_size < count)
+			throw std::length_error("Arena capacity exceeded");
+
+		Type* const ptr = m_data + m_size;
+		m_size += count;
+
+		for (size_t i = 0; i < count; i++)
+			new(ptr + i) Type(source[i]);
+
+		return ptr;
+	}
+}
\ No newline at end of file
@@ -2,35 +2,59 @@
 // SPDX-License-Identifier: MIT
 
 #pragma once
+#include "arena.hpp"
+
 #include <iterator>
-#include <utility>
+#include <limits>
+#include <stdint.h>
 
 namespace dg::impl
 {
 	template <typename Type>
-	struct Node : public Type
+	class Tree
 	{
+	public:
+		using index_type = uint32_t;
+
+		static constexpr index_type s_root = 0;
+		static constexpr index_type s_none = std::numeric_limits<index_type>::max();
+
+		struct Node : public Type
+		{
+			index_type m_parent;
+			index_type m_left = s_none;
+
+			Node(index_type parent, const Type& ref) : Type(ref), m_parent(parent) {}
+
+			bool IsLeaf() const { return m_left == s_none; }
+			index_type Left() const { return m_left; }
+			index_type Right() const { return m_left + 1; }
+		};
+
 		template <int breakAt>
 		struct Iterator
 		{
 			using iterator_category = std::forward_iterator_tag;
 			using difference_type = std::ptrdiff_t;
-			using value_type = Node<Type>;
+			using value_type = Node;
 			using pointer = value_type*;
 			using reference = value_type&;
 
 		private:
-			pointer m_crr = nullptr;
+			pointer m_data = nullptr;
+			index_type m_root = s_none;
+			index_type m_crr = s_none;
 			void Advance(int state);
 
 		public:
 			int m_counter = 0;
 
 			Iterator() = default;
-			Iterator(pointer ptr) : m_crr(ptr) { if (m_crr != nullptr && breakAt != 0) Advance(0); }
+			Iterator(pointer data, index_type root) : m_data(data), m_root(root), m_crr(root) { if (m_crr != s_none && breakAt != 0) Advance(0); }
 
-			pointer operator->() { return m_crr; }
-			reference operator*() const { return *m_crr; }
+			index_type Index() const { return m_crr; }
+			pointer operator->() { return m_data + m_crr; }
+			reference operator*() const { return m_data[m_crr]; }
 
 			auto operator++() -> Iterator& { Advance(breakAt); return *this; }
 			Iterator operator++(int) { Iterator iter = *this; ++(*this); return iter; }
@@ -42,42 +66,89 @@ namespace dg::impl
 		template <int breakAt>
 		struct Range
 		{
-			Node* const m_ptr;
-			Range(Node* ptr) : m_ptr(ptr) {}
+			Node* const m_data;
+			const index_type m_root;
+			Range(Node* data, index_type root) : m_data(data), m_root(root) {}
 
-			Iterator<breakAt> begin() { return Iterator<breakAt>(m_ptr); }
+			Iterator<breakAt> begin() { return Iterator<breakAt>(m_data, m_root); }
 			Iterator<breakAt> end() { return Iterator<breakAt>(); }
 		};
 
-		Node* m_parent;
-		Node* m_left = nullptr;
-		Node* m_right = nullptr;
+	private:
+		Arena<Node> m_nodes;
+
+		template <int breakAt>
+		Range<breakAt> MakeRange(index_type root) { return Range<breakAt>(m_nodes.Data(), Empty() ? s_none : root); }
 
-		Node(Node* parent, Type&& ref) : Type(std::move(ref)), m_parent(parent) {}
-		Node(Node* parent, const Type& ref) : Type(ref), m_parent(parent) {}
-		~Node() = default;
+	public:
+		void Clear() { m_nodes.Clear(); }
+		void Reset() { m_nodes.Reset(); }
+		void Reserve(size_t capacity) { m_nodes.Reserve(capacity); }
 
-		Node(const Node& ref) = delete;
-		Node& operator=(const Node& ref) = delete;
+		void Create(const Type& root);
+		void Attach(index_type index, const Tree& subtree);
+		index_type Split(index_type index);
 
-		Node(Node&& ref) noexcept = delete;
-		Node& operator=(Node&& ref) noexcept = delete;
+		bool Empty() const { return m_nodes.Size() == 0; }
+		size_t Size() const { return m_nodes.Size(); }
 
-		Range<0> Preorder() { return Range<0>(this); }
-		Range<1> Inorder() { return Range<1>(this); }
-		Range<2> Postorder() { return Range<2>(this); }
+		Node& operator[](index_type index) { return m_nodes.Data()[index]; }
+		const Node& operator[](index_type index) const { return m_nodes.Data()[index]; }
+
+		Range<0> Preorder(index_type root = s_root) { return MakeRange<0>(root); }
+		Range<1> Inorder(index_type root = s_root) { return MakeRange<1>(root); }
+		Range<2> Postorder(index_type root = s_root) { return MakeRange<2>(root); }
 	};
 
+	template <typename Type>
+	void Tree<Type>::Create(const Type& root)
+	{
+		m_nodes.Clear();
+		m_nodes.Allocate(1, s_none, root);
+	}
+
+	template <typename Type>
+	void Tree<Type>::Attach(index_type index, const Tree& subtree)
+	{
+		const Node& subroot = subtree[s_root];
+		Node& node = m_nodes.Data()[index];
+
+		static_cast<Type&>(node) = static_cast<const Type&>(subroot);
+		if (subroot.IsLeaf()) return;
+
+		Node* const first = m_nodes.Append(subtree.m_nodes.Data() + 1, subtree.Size() - 1);
+		Node* const last = m_nodes.Data() + m_nodes.Size();
+
+		const index_type offset = static_cast<index_type>(first - m_nodes.Data()) - 1;
+		node.m_left = subroot.m_left + offset;
+
+		for (Node* crr = first; crr != last; ++crr)
+		{
+			crr->m_parent = crr->m_parent != s_root ? crr->m_parent + offset : index;
+			if (crr->m_left != s_none) crr->m_left += offset;
+		}
+	}
+
+	template <typename Type>
+	auto Tree<Type>::Split(index_type index) -> index_type
+	{
+		const Node* const first = m_nodes.Allocate(2, index, static_cast<const Type&>(m_nodes.Data()[index]));
+		const index_type left = static_cast<index_type>(first - m_nodes.Data());
+
+		m_nodes.Data()[index].m_left = left;
+		return left;
+	}
+
 	template <typename Type> template <int breakAt>
-	void Node<Type>::Iterator<breakAt>::Advance(int state)
+	void Tree<Type>::Iterator<breakAt>::Advance(int state)
 	{
-		pointer temp;
+		index_type temp;
 		while (true)
 		{
 			switch (state)
 			{
 			case 0:
-				if (temp = m_crr->m_left; temp != nullptr)
+				if (temp = m_data[m_crr].m_left; temp != s_none)
 				{
 					m_crr = temp;
 					m_counter++;
@@ -93,9 +164,9 @@ namespace dg::impl
 				[[fallthrough]];
 
 			case 1:
-				if (temp = m_crr->m_right; temp != nullptr)
+				if (temp = m_data[m_crr].m_left; temp != s_none)
 				{
-					m_crr = temp;
+					m_crr = temp + 1;
 					m_counter++;
 
 					if constexpr (breakAt == 0)
@@ -112,14 +183,17 @@ namespace dg::impl
 				[[fallthrough]];
 
 			default:
+				if (m_crr == m_root)
+				{
+					m_crr = s_none;
+					return;
+				}
+
 				temp = m_crr;
-				m_crr = m_crr->m_parent;
+				m_crr = m_data[m_crr].m_parent;
 				m_counter--;
 
-				if (m_crr == nullptr)
-					return;
-
-				if (m_crr->m_right == temp)
+				if (m_data[m_crr].m_left != temp)
 				{
 					if constexpr (breakAt == 2)
 						return;
@@ -0,0 +1,223 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#include "cache.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string.h>
+
+namespace dg::impl
+{
+	bool Cache::FindInMemory(uint64_t key, Output& output)
+	{
+		const auto iter = m_index.find(key);
+		if (iter == m_index.end())
+			return false;
+
+		m_entries.splice(m_entries.begin(), m_entries, iter->second);
+		output = iter->second->m_output;
+
+		return true;
+	}
+
+	bool Cache::LoadFromDisk(uint64_t key, Output& output) const
+	{
+		if (m_directory.empty())
+			return false;
+
+		std::ifstream file(GetPath(key), std::ios::binary);
+		if (!file.good())
+			return false;
+
+		// Damaged files are treated like missing ones, so they get overwritten by the regenerated dungeon.
+		try { LoadOutput(file, &output); }
+		catch (const std::exception&) { return false; }
+
+		return true;
+	}
+
+	void Cache::SaveToDisk(uint64_t key, const Output& output) const
+	{
+		if (m_directory.empty())
+			return;
+
+		// Dungeon is written under a temporary name first, so other processes never see an incomplete file.
+		const std::string path = GetPath(key);
+		const std::string temp = path + ".tmp";
+
+		try
+		{
+			std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+			SaveOutput(&output, file);
+			file.close();
+
+			if (file.fail() || std::rename(temp.c_str(), path.c_str()) != 0)
+				std::remove(temp.c_str());
+		}
+		catch (const std::exception&)
+		{
+			std::remove(temp.c_str());
+		}
+	}
+
+	void Cache::Insert(uint64_t key, const Output& output)
+	{
+		if (m_capacity == 0)
+			return;
+
+		if (m_entries.size() < m_capacity)
+			m_entries.emplace_front();
+		else
+		{
+			m_index.erase(m_entries.back().m_key);
+			m_entries.splice(m_entries.begin(), m_entries, std::prev(m_entries.end()));
+		}
+
+		Entry& entry = m_entries.front();
+		entry.m_key = key;
+		entry.m_output = output;
+
+		m_index[key] = m_entries.begin();
+	}
+
+	std::string Cache::GetPath(uint64_t key) const
+	{
+		char name[24];
+		std::snprintf(name, sizeof(name), "%016llx.dgen", static_cast<unsigned long long>(key));
+
+		const char last = m_directory.back();
+		return last == '/' || last == '\\' ? m_directory + name : m_directory + '/' + name;
+	}
+
+	void Cache::Generate(const Input* input, Output* output)
+	{
+		if (input == nullptr)
+			throw std::runtime_error("Pointer to the dg::Input object was null");
+
+		if (output == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output object was null");
+
+		const uint64_t key = Hash(*input);
+
+		if (FindInMemory(key, *output))
+		{
+			m_stats.m_memoryHits++;
+			return;
+		}
+
+		if (LoadFromDisk(key, *output))
+		{
+			m_stats.m_diskHits++;
+			Insert(key, *output);
+			return;
+		}
+
+		m_generator.Generate(input, output);
+		m_stats.m_misses++;
+
+		Insert(key, *output);
+		SaveToDisk(key, *output);
+	}
+
+	void Cache::Clear()
+	{
+		m_entries.clear();
+		m_index.clear();
+		m_generator.Release();
+	}
+
+	uint64_t Cache::Hash(const Input& input)
+	{
+		// Every field which affects the output is mixed in as a fixed-width value, and floats by their bit patterns,
+		// so the hash is the same on every platform. Thread count is skipped, because it doesn't change the result.
+
+		uint64_t hash = s_hashVersion;
+
+		const auto Mix = [&hash](uint64_t value) -> void
+		{
+			uint64_t z = hash ^ (value + 0x9e3779b97f4a7c15);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			hash = z ^ (z >> 31);
+		};
+
+		const auto Int = [&Mix](int value) -> void { Mix(static_cast<uint32_t>(value)); };
+		const auto Float = [&Mix](float value) -> void
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			Mix(bits);
+		};
+
+		Mix(input.m_seed);
+		Int(input.m_width);
+		Int(input.m_height);
+		Int(input.m_minDepth);
+		Int(input.m_maxDepth);
+		Int(input.m_spaceInterdistance);
+		Float(input.m_spaceSizeRandomness);
+		Int(input.m_sparseAreaDepth);
+		Float(input.m_sparseAreaDens);
+		Float(input.m_sparseAreaProb);
+		Float(input.m_minRoomSize);
+		Float(input.m_maxRoomSize);
+		Float(input.m_doubleRoomProb);
+		Float(input.m_heuristicFactor);
+		Float(input.m_pathCostFactor);
+		Int(input.m_extraPathCount);
+		Int(input.m_extraPathDepth);
+		Int(input.m_generateFewerPaths);
+		Int(input.m_parallelDepth);
+
+		return hash;
+	}
+}
+
+namespace dg
+{
+	std::uint64_t HashInput(const Input* input)
+	{
+		if (input == nullptr)
+			throw std::runtime_error("Pointer to the dg::Input object was null");
+
+		return impl::Cache::Hash(*input);
+	}
+
+	Cache::Cache(std::size_t capacity, const std::string& directory) : m_cache(new impl::Cache(capacity, directory)) {}
+	Cache::~Cache() { delete m_cache; }
+
+	Cache::Cache(Cache&& ref) noexcept : m_cache(std::exchange(ref.m_cache, nullptr)) {}
+
+	Cache& Cache::operator=(Cache&& ref) noexcept
+	{
+		if (&ref == this)
+			return *this;
+
+		delete m_cache;
+		m_cache = std::exchange(ref.m_cache, nullptr);
+
+		return *this;
+	}
+
+	void Cache::Generate(const Input* input, Output* output)
+	{
+		if (m_cache == nullptr)
+			throw std::runtime_error("Cache was moved from");
+
+		m_cache->Generate(input, output);
+	}
+
+	CacheStats Cache::GetStats() const
+	{
+		return m_cache != nullptr ? m_cache->m_stats : CacheStats{};
+	}
+
+	void Cache::Clear()
+	{
+		if (m_cache != nullptr)
+			m_cache->Clear();
+	}
+}
\ No newline at end of file
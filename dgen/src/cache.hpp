@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include "dgen_impl.hpp"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace dg::impl
+{
+	struct Cache
+	{
+		// Entries are kept from the most to the least recently used one. When the cache is full,
+		// the last entry is reused for the new dungeon, together with the storage of its output.
+
+		struct Entry
+		{
+			uint64_t m_key = 0;
+			Output m_output;
+		};
+
+		static constexpr uint64_t s_hashVersion = 1;
+
+		const size_t m_capacity;
+		const std::string m_directory;
+
+		CacheStats m_stats{};
+		Generator m_generator;
+
+		std::list<Entry> m_entries;
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+
+		Cache(size_t capacity, const std::string& directory) : m_capacity(capacity), m_directory(directory) {}
+
+		bool FindInMemory(uint64_t key, Output& output);
+		bool LoadFromDisk(uint64_t key, Output& output) const;
+		void SaveToDisk(uint64_t key, const Output& output) const;
+		void Insert(uint64_t key, const Output& output);
+		std::string GetPath(uint64_t key) const;
+
+		void Generate(const Input* input, Output* output);
+		void Clear();
+
+		static uint64_t Hash(const Input& input);
+	};
+}
\ No newline at end of file
@@ -5,21 +5,92 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace dg::impl
 {
-	Vertex Vertex::s_sentinel(std::numeric_limits<decltype(Vertex::m_status)>::max());
+	void Graph::Clear()
+	{
+		m_pos.clear();
+		m_links.clear();
+		m_gcost.clear();
+		m_hcost.clear();
+		m_status.clear();
+		m_origin.clear();
+		m_path.clear();
+		m_roomCount = 0;
+	}
+
+	void Graph::Reset()
+	{
+		std::vector<Point>().swap(m_pos);
+		std::vector<uint32_t>().swap(m_links);
+		std::vector<float>().swap(m_gcost);
+		std::vector<float>().swap(m_hcost);
+		std::vector<uint32_t>().swap(m_status);
+		std::vector<uint8_t>().swap(m_origin);
+		std::vector<uint8_t>().swap(m_path);
+		m_roomCount = 0;
+	}
+
+	void Graph::Prepare(size_t roomCount)
+	{
+		Clear();
+
+		m_pos.reserve(roomCount + 1);
+		m_pos.emplace_back();
+	}
 
-	void Vertex::Unlink()
+	void Graph::Resize(size_t size)
 	{
+		// Positions of rooms are already known, the rest of the data is initialized here.
+
+		m_pos.resize(size);
+		m_links.assign(size << 2, s_sentinel);
+		m_gcost.assign(size, 0.0f);
+		m_hcost.assign(size, 0.0f);
+		m_status.assign(size, 0);
+		m_origin.assign(size, 0);
+		m_path.assign(size, 0);
+
+		m_status[s_sentinel] = std::numeric_limits<uint32_t>::max();
+	}
+
+	void Graph::Restore(const std::vector<uint32_t>& links)
+	{
+		// Links are brought back to the state from before the paths were searched, search data is reset.
+
+		const size_t size = m_pos.size();
+
+		m_links = links;
+		m_gcost.assign(size, 0.0f);
+		m_hcost.assign(size, 0.0f);
+		m_status.assign(size, 0);
+		m_origin.assign(size, 0);
+		m_path.assign(size, 0);
+
+		m_status[s_sentinel] = std::numeric_limits<uint32_t>::max();
+	}
+
+	void Graph::Unlink(uint32_t vertex)
+	{
+		uint32_t* const links = Links(vertex);
 		for (int i = 0; i < 4; i++)
 		{
-			m_links[i]->m_links[i ^ 0b10] = &Vertex::s_sentinel;
-			m_links[i] = &Vertex::s_sentinel;
+			Links(links[i])[i ^ 0b10] = s_sentinel;
+			links[i] = s_sentinel;
 		}
 	}
 
+	uint32_t Graph::AddRoom(Point pos)
+	{
+		m_pos.push_back(pos);
+		return FromRoom(m_roomCount++);
+	}
+
 	Tag::Tag(int high, int low)
 		: m_pos((static_cast<uint64_t>(high) << 32) | static_cast<uint64_t>(low)) {}
 
@@ -32,50 +103,269 @@ namespace dg::impl
 		m_data.m_hasIndex = 1;
 	}
 
-	RadixSort::RadixSort(const size_t maxSize)
-		: m_memory(operator new[](sizeof(size_t) * 256 + sizeof(Tag) * maxSize)) {}
+	RadixSort::RadixSort(const size_t maxSize, ThreadPool* threadPool, size_t threadCount)
+		: m_memory(operator new[](sizeof(size_t) * s_countSize + sizeof(Tag) * maxSize)), m_threadPool(threadPool), m_threadCount(threadCount) {}
 
 	RadixSort::~RadixSort() { operator delete[](m_memory); }
 
 	void RadixSort::Sort(Tag* arr, const size_t size) const
 	{
-		static constexpr auto s_overflow = static_cast<size_t>(0) - 1;
-		size_t* const count = static_cast<size_t*>(m_memory);
-		Tag* temp = reinterpret_cast<Tag*>(count + 256);
+		// Bits which are the same in every key don't affect the order, so digits made only of them are skipped.
+		// Coordinates are much narrower than their 32-bit halves, which usually leaves 4 passes out of 8.
+
+		if (size < 2)
+			return;
+
+		uint64_t mask = 0;
+		const uint64_t first = arr->m_pos;
+
+		if (const size_t chunkCount = GetChunkCount(size); chunkCount > 1)
+		{
+			std::vector<uint64_t> masks(chunkCount);
+			const size_t chunkSize = (size + chunkCount - 1) / chunkCount;
 
-		for (int bits = 0; bits < 64; bits += 8)
+			m_threadPool->Run(chunkCount, chunkCount, [arr, size, first, chunkSize, &masks](size_t chunk, size_t) -> void
+			{
+				const size_t end = std::min(size, (chunk + 1) * chunkSize);
+				for (size_t i = chunk * chunkSize; i < end; i++)
+					masks[chunk] |= arr[i].m_pos ^ first;
+			});
+
+			for (const uint64_t chunkMask : masks)
+				mask |= chunkMask;
+		}
+		else
 		{
-			for (size_t i = 0; i < 256; i++)
-				count[i] = 0;
+			for (size_t i = 1; i < size; i++)
+				mask |= arr[i].m_pos ^ first;
+		}
+
+		if (mask == 0)
+			return;
+
+		if (CountDigits<11>(mask) < CountDigits<8>(mask))
+			SortDigits<11>(arr, size, mask);
+		else
+			SortDigits<8>(arr, size, mask);
+	}
+
+	void RadixSort::Sort(Tag* arr, const size_t size, const size_t columns, const size_t rows) const
+	{
+		// Tags of a map lie within its bounds, so a stable counting pass by row followed by one by column sorts them
+		// in two scatters, whereas radix digits of both coordinates usually take four. The parallel radix sort still
+		// wins on large arrays.
+
+		if (size < 2 || GetChunkCount(size) > 1)
+		{
+			Sort(arr, size);
+			return;
+		}
+
+		std::vector<size_t> buffer;
+		size_t* counts = static_cast<size_t*>(m_memory);
+
+		if (columns + rows > s_countSize)
+		{
+			buffer.resize(columns + rows);
+			counts = buffer.data();
+		}
+
+		size_t* const xCount = counts;
+		size_t* const yCount = counts + columns;
+		Tag* const temp = reinterpret_cast<Tag*>(static_cast<size_t*>(m_memory) + s_countSize);
+
+		std::fill(counts, counts + columns + rows, 0);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			const uint64_t pos = arr[i].m_pos;
+			++xCount[pos >> 32];
+			++yCount[pos & 0xFFFFFFFF];
+		}
+
+		for (size_t x = 0, sum = 0; x < columns; x++)
+			sum += std::exchange(xCount[x], sum);
+
+		for (size_t y = 0, sum = 0; y < rows; y++)
+			sum += std::exchange(yCount[y], sum);
+
+		for (size_t i = 0; i < size; i++)
+			temp[yCount[arr[i].m_pos & 0xFFFFFFFF]++] = arr[i];
+
+		for (size_t i = 0; i < size; i++)
+			arr[xCount[temp[i].m_pos >> 32]++] = temp[i];
+	}
+
+	template <int digitBits>
+	void RadixSort::SortDigits(Tag* arr, const size_t size, const uint64_t mask) const
+	{
+		static constexpr int s_digitCount = (63 + digitBits) / digitBits;
+		static constexpr size_t s_radix = static_cast<size_t>(1) << digitBits;
+		static constexpr uint64_t s_digitMask = s_radix - 1;
+
+		static_assert(s_radix * s_digitCount <= s_countSize);
+
+		int shifts[s_digitCount]{};
+		int passes = 0;
+
+		for (int i = 0; i < s_digitCount; i++)
+		{
+			if ((mask >> (i * digitBits)) & s_digitMask)
+				shifts[passes++] = i * digitBits;
+		}
+
+		size_t* const counts = static_cast<size_t*>(m_memory);
+		Tag* const data = arr;
+		Tag* temp = reinterpret_cast<Tag*>(counts + s_countSize);
+
+		if (GetChunkCount(size) > 1)
+		{
+			arr = SortDigitsInParallel<digitBits>(arr, temp, size, shifts, passes);
+			if (arr != data)
+				std::copy(arr, arr + size, data);
+
+			return;
+		}
+
+		std::fill(counts, counts + s_radix * passes, 0);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			const uint64_t pos = arr[i].m_pos;
+			for (int j = 0; j < passes; j++)
+				++counts[s_radix * j + ((pos >> shifts[j]) & s_digitMask)];
+		}
+
+		for (int j = 0; j < passes; j++)
+		{
+			size_t* const count = counts + s_radix * j;
+			size_t sum = 0;
+
+			for (size_t i = 0; i < s_radix; i++)
+				sum += std::exchange(count[i], sum);
+		}
+
+		for (int j = 0; j < passes; j++)
+		{
+			size_t* const count = counts + s_radix * j;
+			const int shift = shifts[j];
 
 			for (size_t i = 0; i < size; i++)
-				++count[(arr[i].m_pos >> bits) & 0xFF];
+				temp[count[(arr[i].m_pos >> shift) & s_digitMask]++] = arr[i];
 
-			size_t prev = *count;
-			for (size_t i = 1; i < 256; i++)
-				prev = (count[i] += prev);
+			std::swap(arr, temp);
+		}
+
+		if (arr != data)
+			std::copy(arr, arr + size, data);
+	}
+
+	template <int digitBits>
+	Tag* RadixSort::SortDigitsInParallel(Tag* arr, Tag* temp, const size_t size, const int* shifts, int passes) const
+	{
+		// Each thread counts digits in its own chunk. Chunks are then scattered to offsets that precede
+		// equal digits of all later chunks, which keeps the sort stable and the order identical to the serial one.
 
-			for (size_t i = size - 1; i != s_overflow; i--)
-				temp[--count[(arr[i].m_pos >> bits) & 0xFF]] = arr[i];
+		static constexpr size_t s_radix = static_cast<size_t>(1) << digitBits;
+		static constexpr uint64_t s_digitMask = s_radix - 1;
+
+		const size_t chunkCount = GetChunkCount(size);
+		const size_t chunkSize = (size + chunkCount - 1) / chunkCount;
+		std::vector<size_t> counts(s_radix * chunkCount);
+
+		for (int j = 0; j < passes; j++)
+		{
+			const int shift = shifts[j];
+
+			m_threadPool->Run(chunkCount, chunkCount, [arr, size, shift, chunkSize, &counts](size_t chunk, size_t) -> void
+			{
+				size_t* const count = counts.data() + s_radix * chunk;
+				std::fill(count, count + s_radix, 0);
+
+				const size_t end = std::min(size, (chunk + 1) * chunkSize);
+				for (size_t i = chunk * chunkSize; i < end; i++)
+					++count[(arr[i].m_pos >> shift) & s_digitMask];
+			});
+
+			size_t sum = 0;
+			for (size_t i = 0; i < s_radix; i++)
+			{
+				for (size_t chunk = 0; chunk < chunkCount; chunk++)
+					sum += std::exchange(counts[s_radix * chunk + i], sum);
+			}
+
+			m_threadPool->Run(chunkCount, chunkCount, [arr, temp, size, shift, chunkSize, &counts](size_t chunk, size_t) -> void
+			{
+				size_t* const count = counts.data() + s_radix * chunk;
+
+				const size_t end = std::min(size, (chunk + 1) * chunkSize);
+				for (size_t i = chunk * chunkSize; i < end; i++)
+					temp[count[(arr[i].m_pos >> shift) & s_digitMask]++] = arr[i];
+			});
 
 			std::swap(arr, temp);
 		}
+
+		return arr;
+	}
+
+	template <int digitBits>
+	int RadixSort::CountDigits(const uint64_t mask)
+	{
+		static constexpr uint64_t s_digitMask = (static_cast<uint64_t>(1) << digitBits) - 1;
+
+		int count = 0;
+		for (int shift = 0; shift < 64; shift += digitBits)
+			count += ((mask >> shift) & s_digitMask) != 0;
+
+		return count;
+	}
+
+	size_t RadixSort::GetChunkCount(const size_t size) const
+	{
+		if (m_threadPool == nullptr || size < s_parallelThreshold)
+			return 1;
+
+		return m_threadCount;
+	}
+
+	void RetainedState::Reset()
+	{
+		m_valid = false;
+
+		std::vector<Rect>().swap(m_rooms);
+		std::vector<uint32_t>().swap(m_links);
+		std::vector<uint8_t>().swap(m_paths);
 	}
 
 	void Generator::Clear()
 	{
+		m_retained.m_valid = false;
+
 		m_tags.clear();
 		m_rooms.clear();
-		m_vertices.clear();
-		m_vertexHeap.Clear();
+		m_graph.Clear();
+		m_vertexQueues.Clear();
 
-		if (m_rootNode != nullptr)
-		{
-			DeleteTree(m_rootNode);
+		m_tree.Clear();
+	}
 
-			delete m_rootNode;
-			m_rootNode = nullptr;
-		}
+	void Generator::Release()
+	{
+		Clear();
+
+		std::vector<Tag>().swap(m_tags);
+		std::vector<Room>().swap(m_rooms);
+		m_graph.Reset();
+		m_vertexQueues.Reset();
+		m_tree.Reset();
+		m_retained.Reset();
+
+		std::vector<Branch>().swap(m_branches);
+		std::vector<PathTask>().swap(m_pathTasks);
+		std::vector<WorkerSearch>().swap(m_pathWorkers);
+		std::vector<std::pair<uint32_t, uint32_t>>().swap(m_pathRequests);
+		m_threadPool.Reset();
 	}
 
 	void Generator::Verify()
@@ -116,14 +406,60 @@ namespace dg::impl
 		valid &= m_input->m_extraPathCount >= 0;
 		valid &= m_input->m_extraPathDepth >= 0;
 		valid &= m_input->m_extraPathDepth <= m_input->m_maxDepth;
+		valid &= m_input->m_parallelDepth >= 0;
+		valid &= m_input->m_parallelDepth <= m_input->m_maxDepth;
+		valid &= m_input->m_threadCount >= 0;
 
 		if (!valid)
 			throw std::runtime_error("Invalid input data");
 	}
 
+	Stage Generator::GetFirstStage() const
+	{
+		// The tree, rooms and vertices depend on every parameter apart from the ones below. Path requests
+		// depend on m_extraPathCount, while the search itself depends on both cost factors. Only the
+		// optimization of vertices uses m_generateFewerPaths. Thread count never changes the result.
+
+		if (!m_retained.m_valid)
+			return Stage::TREE;
+
+		const Input& prev = m_retained.m_input;
+		const Input& crr = *m_input;
+
+		bool same = true;
+
+		same &= crr.m_seed == prev.m_seed;
+		same &= crr.m_width == prev.m_width;
+		same &= crr.m_height == prev.m_height;
+		same &= crr.m_minDepth == prev.m_minDepth;
+		same &= crr.m_maxDepth == prev.m_maxDepth;
+		same &= crr.m_spaceInterdistance == prev.m_spaceInterdistance;
+		same &= crr.m_spaceSizeRandomness == prev.m_spaceSizeRandomness;
+		same &= crr.m_sparseAreaDepth == prev.m_sparseAreaDepth;
+		same &= crr.m_sparseAreaDens == prev.m_sparseAreaDens;
+		same &= crr.m_sparseAreaProb == prev.m_sparseAreaProb;
+		same &= crr.m_minRoomSize == prev.m_minRoomSize;
+		same &= crr.m_maxRoomSize == prev.m_maxRoomSize;
+		same &= crr.m_doubleRoomProb == prev.m_doubleRoomProb;
+		same &= crr.m_extraPathDepth == prev.m_extraPathDepth;
+		same &= crr.m_parallelDepth == prev.m_parallelDepth;
+
+		if (!same)
+			return Stage::TREE;
+
+		same &= crr.m_heuristicFactor == prev.m_heuristicFactor;
+		same &= crr.m_pathCostFactor == prev.m_pathCostFactor;
+		same &= crr.m_extraPathCount == prev.m_extraPathCount;
+
+		return same ? Stage::OPTIMIZE : Stage::PATHS;
+	}
+
 	void Generator::Prepare()
 	{
-		*m_output = {};
+		m_output->m_rooms.clear();
+		m_output->m_entrances.clear();
+		m_output->m_paths.clear();
+
 		m_random.Seed(m_input->m_seed);
 
 		m_spaceOffset = m_input->m_spaceInterdistance + 1;
@@ -135,63 +471,111 @@ namespace dg::impl
 		if (m_input->m_width <= m_minSpaceSize || m_input->m_height <= m_minSpaceSize)
 			throw std::runtime_error("Root node is too small");
 
-		m_rootNode = new Node<Cell>(nullptr, Cell(m_input->m_width - 1, m_input->m_height - 1));
+		const Cell root(m_input->m_width - 1, m_input->m_height - 1);
+
+		m_tree.Reserve(GetNodeLimit(root.m_space, m_input->m_maxDepth));
+		m_tree.Create(root);
 
-		m_targetDepth = 0;
 		m_statusCounter = 1;
 		m_totalRoomCount = 0;
 		m_partialPathCount = 0;
 
 		m_deltaDepth = m_input->m_maxDepth - m_input->m_minDepth;
+		m_branchLeft = m_input->m_parallelDepth > 0 ? m_input->m_maxDepth - m_input->m_parallelDepth : -1;
 		m_randPathDepth = m_input->m_maxDepth - m_input->m_extraPathDepth;
 	}
 
-	uint32_t Generator::GenerateTree(Node<Cell>& node, int left)
+	void Generator::Restore(Stage stage)
+	{
+		// Rooms and the tree are kept from the previous call, so only the output and the graph are restored.
+
+		m_output->m_rooms = m_retained.m_rooms;
+		m_output->m_entrances.clear();
+		m_output->m_paths.clear();
+
+		m_graph.Restore(m_retained.m_links);
+		m_vertexQueues.Clear();
+
+		if (stage == Stage::PATHS)
+			m_random = m_retained.m_random;
+		else
+			m_graph.m_path = m_retained.m_paths;
+
+		m_statusCounter = 1;
+		m_partialPathCount = 0;
+	}
+
+	void Generator::GenerateTree()
+	{
+		TreeState state{ m_tree, m_tags, m_random };
+		state.m_branchLeft = m_branchLeft;
+
+		m_branchCount = 0;
+		GenerateTree(state, Tree<Cell>::s_root, m_input->m_maxDepth);
+		m_totalRoomCount = state.m_roomCount;
+
+		if (m_branchCount == 0)
+			return;
+
+		const size_t threadCount = ThreadPool::GetThreadCount(m_input->m_threadCount);
+		m_threadPool.Run(m_branchCount, threadCount, [this](size_t i, size_t) -> void { GenerateBranch(m_branches[i], m_branchLeft); });
+
+		size_t branchIndex = 0;
+		AttachBranches(Tree<Cell>::s_root, m_input->m_maxDepth, branchIndex);
+	}
+
+	uint32_t Generator::GenerateTree(TreeState& state, uint32_t index, int left)
 	{
+		if (left == state.m_branchLeft)
+		{
+			AddBranch(index, state.m_targetDepth);
+			return 0;
+		}
+
+		Tree<Cell>::Node& node = state.m_tree[index];
+
 		node.m_flags |= static_cast<uint32_t>(left <= m_randPathDepth) << Cell::Flag::RANDOM_PATH;
 
 		if (left <= m_input->m_sparseAreaDepth)
-			node.m_flags |= static_cast<uint32_t>(m_random.GetFP32() < m_input->m_sparseAreaProb) << Cell::Flag::SPARSE_AREA;
+			node.m_flags |= static_cast<uint32_t>(state.m_random.GetFP32() < m_input->m_sparseAreaProb) << Cell::Flag::SPARSE_AREA;
 
 		if (left == m_deltaDepth && m_deltaDepth > 0)
-			m_targetDepth = m_random.Get32() % (m_deltaDepth + 1);
+			state.m_targetDepth = state.m_random.Get32() % (m_deltaDepth + 1);
 
-		if (left <= m_targetDepth)
-			return MakeLeafCell(node);
+		if (left <= state.m_targetDepth)
+			return MakeLeafCell(state, node);
 
 		static constexpr std::pair<int Rect::*, int Rect::*> xw = std::make_pair(&Rect::x, &Rect::w);
 		static constexpr std::pair<int Rect::*, int Rect::*> yh = std::make_pair(&Rect::y, &Rect::h);
 
 		const auto& [xy, wh] = node.m_space.w >= node.m_space.h ? xw : yh;
-		const float c = m_random.GetFP32() * (m_input->m_spaceSizeRandomness) + m_minSpaceRand;
+		const float c = state.m_random.GetFP32() * (m_input->m_spaceSizeRandomness) + m_minSpaceRand;
 
 		const int totalSize = node.m_space.*wh;
 		const int randSize = static_cast<int>(totalSize * c);
 
 		if (randSize < m_minSpaceSize || totalSize - randSize < m_minSpaceSize)
-			return MakeLeafCell(node);
+			return MakeLeafCell(state, node);
 
-		node.m_left = static_cast<Node<Cell>*>(operator new[](sizeof(Node<Cell>) * 2));
-		node.m_right = node.m_left + 1;
+		state.m_tree.Split(index);
 
-		new(node.m_left) Node<Cell>(&node, node);
-		new(node.m_right) Node<Cell>(&node, node);
+		Cell& leftCell = state.m_tree[node.Left()];
+		Cell& rightCell = state.m_tree[node.Right()];
 
-		node.m_left->m_space.*wh = randSize;
-		node.m_right->m_space.*xy += randSize;
-		node.m_right->m_space.*wh -= randSize;
+		leftCell.m_space.*wh = randSize;
+		rightCell.m_space.*xy += randSize;
+		rightCell.m_space.*wh -= randSize;
 
-		const uint32_t l = GenerateTree(*node.m_left, --left);
-		const uint32_t r = GenerateTree(*node.m_right, left);
+		const uint32_t l = GenerateTree(state, node.Left(), --left);
+		const uint32_t r = GenerateTree(state, node.Right(), left);
 
-		node.m_roomOffset = std::min(node.m_left->m_roomOffset, node.m_right->m_roomOffset);
-		node.m_roomCount = node.m_left->m_roomCount + node.m_right->m_roomCount;
+		node.m_roomCount = leftCell.m_roomCount + rightCell.m_roomCount;
 		node.m_flags |= l & r;
 
 		return l | r;
 	}
 
-	uint32_t Generator::MakeLeafCell(Node<Cell>& node)
+	uint32_t Generator::MakeLeafCell(TreeState& state, Tree<Cell>::Node& node)
 	{
 		Rect& space = node.m_space;
 
@@ -205,36 +589,106 @@ namespace dg::impl
 		const int xMax = space.x + space.w + d1;
 		const int yMax = space.y + space.h + d1;
 
-		m_tags.emplace_back(xMax, yMax).m_data.m_linkBits = (1ULL << Dir::NORTH) | (1ULL << Dir::WEST);
-		m_tags.emplace_back(xMin, yMax).m_data.m_linkBits = 1ULL << Dir::NORTH;
-		m_tags.emplace_back(xMax, yMin).m_data.m_linkBits = 1ULL << Dir::WEST;
-		m_tags.emplace_back(xMin, yMin);
+		state.m_tags.emplace_back(xMax, yMax).m_data.m_linkBits = (1ULL << Dir::NORTH) | (1ULL << Dir::WEST);
+		state.m_tags.emplace_back(xMin, yMax).m_data.m_linkBits = 1ULL << Dir::NORTH;
+		state.m_tags.emplace_back(xMax, yMin).m_data.m_linkBits = 1ULL << Dir::WEST;
+		state.m_tags.emplace_back(xMin, yMin);
 
 		uint32_t flagsToReturn = 0;
-		if ((node.m_flags & (1 << Cell::Flag::SPARSE_AREA)) == 0 || m_random.GetFP32() < m_input->m_sparseAreaDens)
+		if ((node.m_flags & (1 << Cell::Flag::SPARSE_AREA)) == 0 || state.m_random.GetFP32() < m_input->m_sparseAreaDens)
 		{
 			flagsToReturn = 1 << Cell::Flag::CONNECT_ROOMS;
 			node.m_flags |= 1 << Cell::Flag::GENERATE_ROOMS;
-			node.m_roomOffset = m_totalRoomCount++;
 			node.m_roomCount = 1;
+			state.m_roomCount++;
 		}
 
 		return flagsToReturn;
 	}
 
+	void Generator::AddBranch(uint32_t index, int targetDepth)
+	{
+		if (m_branchCount == m_branches.size())
+			m_branches.emplace_back();
+
+		Branch& branch = m_branches[m_branchCount++];
+		branch.m_index = index;
+		branch.m_targetDepth = targetDepth;
+
+		// Each branch draws from its own stream, identified by the path leading to it.
+		// This way the result doesn't depend on the order in which branches are generated.
+
+		uint64_t path = 1;
+		for (uint32_t crr = index; crr != Tree<Cell>::s_root; crr = m_tree[crr].m_parent)
+			path = (path << 1) | static_cast<uint64_t>(m_tree[m_tree[crr].m_parent].Left() != crr);
+
+		branch.m_random.Seed(m_input->m_seed, path);
+	}
+
+	void Generator::GenerateBranch(Branch& branch, int left)
+	{
+		const Cell& root = m_tree[branch.m_index];
+
+		branch.m_tags.clear();
+		branch.m_tree.Clear();
+		branch.m_tree.Reserve(GetNodeLimit(root.m_space, left));
+		branch.m_tree.Create(root);
+
+		TreeState state{ branch.m_tree, branch.m_tags, branch.m_random, branch.m_targetDepth };
+		branch.m_flags = GenerateTree(state, Tree<Cell>::s_root, left);
+		branch.m_roomCount = state.m_roomCount;
+	}
+
+	uint32_t Generator::AttachBranches(uint32_t index, int left, size_t& branchIndex)
+	{
+		Tree<Cell>::Node& node = m_tree[index];
+		if (left == m_branchLeft)
+		{
+			const Branch& branch = m_branches[branchIndex++];
+
+			m_tree.Attach(index, branch.m_tree);
+			m_tags.insert(m_tags.end(), branch.m_tags.begin(), branch.m_tags.end());
+			m_totalRoomCount += branch.m_roomCount;
+
+			return branch.m_flags;
+		}
+
+		if (node.IsLeaf())
+			return (node.m_flags & (1 << Cell::Flag::GENERATE_ROOMS)) ? 1 << Cell::Flag::CONNECT_ROOMS : 0;
+
+		const uint32_t l = AttachBranches(node.Left(), left - 1, branchIndex);
+		const uint32_t r = AttachBranches(node.Right(), left - 1, branchIndex);
+
+		node.m_roomCount = m_tree[node.Left()].m_roomCount + m_tree[node.Right()].m_roomCount;
+		node.m_flags |= l & r;
+
+		return l | r;
+	}
+
 	void Generator::GenerateRooms()
 	{
 		const float minRoomSize = m_input->m_minRoomSize;
 		const float diffRoomSize = m_input->m_maxRoomSize - m_input->m_minRoomSize;
 
 		m_rooms.reserve(static_cast<size_t>(m_totalRoomCount));
+		m_graph.Prepare(static_cast<size_t>(m_totalRoomCount));
 		m_output->m_rooms.reserve(static_cast<size_t>(m_totalRoomCount) << 1);
 
-		for (auto& node : m_rootNode->Postorder())
+		auto range = m_tree.Postorder();
+		for (auto iter = range.begin(); iter != range.end(); ++iter)
 		{
+			Tree<Cell>::Node& node = *iter;
+			if (!node.IsLeaf())
+			{
+				node.m_roomOffset = std::min(m_tree[node.Left()].m_roomOffset, m_tree[node.Right()].m_roomOffset);
+				continue;
+			}
+
 			if ((node.m_flags & (1 << Cell::Flag::GENERATE_ROOMS)) == 0)
 				continue;
 
+			node.m_roomOffset = static_cast<int>(m_rooms.size());
+
 			const float a = m_random.GetFP32() * diffRoomSize + minRoomSize;
 			const float b = m_random.GetFP32() * diffRoomSize + minRoomSize;
 
@@ -284,13 +738,13 @@ namespace dg::impl
 			const Vec offset(c % (remSize.x + 1), d % (remSize.y + 1));
 
 			Point pos[2]{};
-			Room& room = m_rooms.emplace_back(node);
+			Room& room = m_rooms.emplace_back(iter.Index());
 
 			room.m_rectBegin = m_output->m_rooms.size();
 			m_output->m_rooms.emplace_back(priPos.x + offset.x, priPos.y + offset.y, priSize.x, priSize.y);
 
 			room.m_rectEnd = m_output->m_rooms.size();
-			room.m_pos = Point(priPos.x + offset.x + (priSize.x >> 1), priPos.y + offset.y + (priSize.y >> 1));
+			m_graph.AddRoom(Point(priPos.x + offset.x + (priSize.x >> 1), priPos.y + offset.y + (priSize.y >> 1)));
 
 			if (secPos.x == -1)
 			{
@@ -398,201 +852,426 @@ namespace dg::impl
 
 	void Generator::CreateVertices()
 	{
-		RadixSort rs(m_tags.size());
-		rs.Sort(m_tags.data(), m_tags.size());
+		RadixSort rs(m_tags.size(), &m_threadPool, ThreadPool::GetThreadCount(m_input->m_threadCount));
+		rs.Sort(m_tags.data(), m_tags.size(), static_cast<size_t>(m_input->m_width), static_cast<size_t>(m_input->m_height));
 
 		size_t count = 0;
+		uint64_t rowCount = 0;
 		uint64_t pos = std::numeric_limits<uint64_t>::max();
 
 		for (const Tag& tag : m_tags)
 		{
 			count += pos != tag.m_pos;
 			pos = tag.m_pos;
+			rowCount = std::max(rowCount, (pos & 0xFFFFFFFF) + 1);
 		}
 
-		std::vector<Tag> revTags(count);
-		m_vertices.resize(count);
+		const uint32_t first = m_graph.VertexBegin();
+		m_graph.Resize(first + count);
+
+		uint32_t vertex = first - 1;
 
-		Tag* revTag = revTags.data() - 1;
-		Vertex* vertex = m_vertices.data() - 1;
+		uint32_t pri[2] = { Graph::s_sentinel, Graph::s_sentinel };
+		uint32_t sec[2] = { Graph::s_sentinel, Graph::s_sentinel };
 
-		Vertex* pri[2] = { &Vertex::s_sentinel, &Vertex::s_sentinel };
-		Vertex* sec[2] = { &Vertex::s_sentinel, &Vertex::s_sentinel };
+		const float middle = (s_verticesProgress + s_pathsProgress) * 0.5f;
 
 		pos = std::numeric_limits<uint64_t>::max();
-		for (const Tag& tag : m_tags)
+		for (size_t i = 0; i < m_tags.size(); i++)
 		{
+			if (i % s_vertexCheckInterval == 0)
+				Report(s_verticesProgress, middle, i, m_tags.size());
+
+			const Tag& tag = m_tags[i];
 			const size_t diff = pos != tag.m_pos;
 
 			pos = tag.m_pos;
-			vertex += diff;
-			revTag += diff;
-
-			const uint64_t xPos = pos >> 32;
+			vertex += static_cast<uint32_t>(diff);
 
-			revTag->m_pos = (pos << 32) | xPos;
-			revTag->m_vertex = vertex;
-
-			vertex->m_pos.x = static_cast<int>(xPos);
-			vertex->m_pos.y = static_cast<int>(pos & 0xFFFFFFFF);
-			vertex->m_path |= tag.m_data.m_linkBits;
+			m_graph.m_pos[vertex].x = static_cast<int>(pos >> 32);
+			m_graph.m_pos[vertex].y = static_cast<int>(pos & 0xFFFFFFFF);
+			m_graph.m_path[vertex] |= tag.m_data.m_linkBits;
 
 			pri[1] = vertex;
-			sec[1] = m_rooms.data() + tag.m_data.m_index;
+			sec[1] = Graph::FromRoom(tag.m_data.m_index);
 
 			const int exists = tag.m_data.m_hasIndex;
 
-			pri[exists]->m_links[tag.m_data.m_origin] = sec[exists];
-			sec[exists]->m_links[tag.m_data.m_origin ^ 0b10] = pri[exists];
+			m_graph.Links(pri[exists])[tag.m_data.m_origin] = sec[exists];
+			m_graph.Links(sec[exists])[tag.m_data.m_origin ^ 0b10] = pri[exists];
 		}
 
 		m_tags.clear();
-		for (Vertex& crr : m_vertices)
-		{
-			const int exists = (crr.m_path >> Dir::NORTH) & 1;
 
-			pri[1] = &crr;
-			pri[exists]->m_links[Dir::NORTH] = sec[exists];
-			sec[exists]->m_links[Dir::SOUTH] = pri[exists];
-			sec[1] = pri[1];
-		}
+		// Vertices are ordered by column, so the last vertex seen in a row is the western neighbour of the next one.
+		std::vector<uint32_t> rows(static_cast<size_t>(rowCount), Graph::s_sentinel);
+		uint32_t west[2] = { Graph::s_sentinel, Graph::s_sentinel };
 
-		rs.Sort(revTags.data(), revTags.size());
-		for (const Tag& tag : revTags)
+		for (uint32_t crr = first; crr < m_graph.Size(); crr++)
 		{
-			Vertex* const crr = tag.m_vertex;
-			const int exists = (crr->m_path >> Dir::WEST) & 1;
+			if ((crr - first) % s_vertexCheckInterval == 0)
+				Report(middle, s_pathsProgress, crr - first, count);
+
+			const uint8_t linkBits = m_graph.m_path[crr];
+			const int north = (linkBits >> Dir::NORTH) & 1;
+			const int exists = (linkBits >> Dir::WEST) & 1;
 
 			pri[1] = crr;
-			pri[exists]->m_links[Dir::WEST] = sec[exists];
-			sec[exists]->m_links[Dir::EAST] = pri[exists];
+			m_graph.Links(pri[north])[Dir::NORTH] = sec[north];
+			m_graph.Links(sec[north])[Dir::SOUTH] = pri[north];
 			sec[1] = pri[1];
 
-			crr->m_path = 0;
+			uint32_t& row = rows[m_graph.m_pos[crr].y];
+
+			west[1] = row;
+			m_graph.Links(pri[exists])[Dir::WEST] = west[exists];
+			m_graph.Links(west[exists])[Dir::EAST] = pri[exists];
+			row = crr;
+
+			m_graph.m_path[crr] = 0;
 		}
 	}
 
+	void VertexQueues::Clear()
+	{
+		m_heap.Clear();
+		m_radixHeap.Clear();
+		m_indexedHeap.Clear();
+	}
+
+	void VertexQueues::Reset()
+	{
+		m_heap.Reset();
+		m_radixHeap.Reset();
+		m_indexedHeap.Reset();
+	}
+
+	void WorkerSearch::Prepare(const Graph& graph, QueuePolicy policy)
+	{
+		m_graph = &graph;
+
+		m_states.assign(graph.Size(), SearchState());
+		m_states[Graph::s_sentinel].m_status = std::numeric_limits<uint32_t>::max();
+
+		m_statusCounter = 1;
+		m_queues.Clear();
+
+		if (policy == QueuePolicy::INDEXED_HEAP)
+			m_queues.m_indexedHeap.Resize(graph.Size());
+	}
+
+	void WorkerSearch::Finish()
+	{
+		for (const auto& [vertex, bits] : m_task->m_marks)
+			m_states[vertex].m_path = 0;
+
+		m_task = nullptr;
+	}
+
+	uint8_t WorkerSearch::Visit(uint32_t vertex)
+	{
+		const uint8_t committed = m_graph->m_path[vertex];
+		m_task->m_visited.emplace_back(vertex, committed);
+
+		return committed | m_states[vertex].m_path;
+	}
+
+	void WorkerSearch::Mark(uint32_t vertex, uint8_t bits)
+	{
+		uint8_t& path = m_states[vertex].m_path;
+		if (path == 0)
+			m_task->m_marks.emplace_back(vertex, 0);
+
+		path |= bits;
+	}
+
 	void Generator::FindPaths()
 	{
-		for (auto& node : m_rootNode->Postorder())
+		const size_t threadCount = ThreadPool::GetThreadCount(m_input->m_threadCount);
+		const bool parallel = m_speculativePaths && threadCount > 1 && m_graph.Size() >= s_parallelPathThreshold;
+
+		int taskDepth = -1;
+		if (parallel)
 		{
-			if ((node.m_flags & (1 << Cell::Flag::CONNECT_ROOMS)) == 0)
-				continue;
+			taskDepth = 0;
+			while ((static_cast<size_t>(1) << taskDepth) < threadCount * s_pathTasksPerThread && taskDepth < m_input->m_maxDepth)
+				taskDepth++;
+		}
+
+		CollectPaths(taskDepth);
 
-			if (node.m_flags & (1 << Cell::Flag::RANDOM_PATH))
+		if (m_queuePolicy == QueuePolicy::INDEXED_HEAP)
+			m_vertexQueues.m_indexedHeap.Resize(m_graph.Size());
+
+		if (parallel && !m_pathTasks.empty())
+			FindPathsInParallel(threadCount);
+		else
+		{
+			VertexSearch search{ m_statusCounter, m_graph };
+			const size_t size = m_pathRequests.size();
+
+			for (size_t begin = 0; begin < size; begin += s_pathCheckInterval)
 			{
-				int leftIndex = node.m_left->m_roomOffset;
-				const int leftCount = node.m_left->m_roomCount;
+				Report(s_pathsProgress, s_optimizeProgress, begin, size);
+				FindPaths(search, m_vertexQueues, begin, std::min(begin + s_pathCheckInterval, size));
+			}
+		}
+	}
 
-				int rightIndex = node.m_right->m_roomOffset;
-				const int rightCount = node.m_right->m_roomCount;
+	void Generator::CollectPaths(int taskDepth)
+	{
+		// Random choices don't depend on previously found paths, so they can be made up front.
+		// Requests are stored in the exact order in which the serial algorithm processes them.
+		// Subtrees at taskDepth occupy contiguous ranges of requests, which become path tasks.
 
-				if (leftCount > 1)
-					leftIndex += m_random.Get32() % leftCount;
+		m_pathTasks.clear();
+		m_pathRequests.clear();
 
-				if (rightCount > 1)
-					rightIndex += m_random.Get32() % rightCount;
+		size_t taskBegin = 0;
+		auto range = m_tree.Postorder();
 
-				FindPath(m_rooms.data() + leftIndex, m_rooms.data() + rightIndex);
-			}
-			else
+		for (auto iter = range.begin(); iter != range.end(); ++iter)
+		{
+			const Tree<Cell>::Node& node = *iter;
+			if (node.m_flags & (1 << Cell::Flag::CONNECT_ROOMS))
 			{
-				int n = m_input->m_extraPathCount + 1;
-				const int d = m_input->m_extraPathCount + 2;
+				const Cell& leftCell = m_tree[node.Left()];
+				const Cell& rightCell = m_tree[node.Right()];
+
+				if (node.m_flags & (1 << Cell::Flag::RANDOM_PATH))
+				{
+					int leftIndex = leftCell.m_roomOffset;
+					const int leftCount = leftCell.m_roomCount;
+
+					int rightIndex = rightCell.m_roomOffset;
+					const int rightCount = rightCell.m_roomCount;
+
+					if (leftCount > 1)
+						leftIndex += m_random.Get32() % leftCount;
 
-				const auto [xL, yL, wL, hL] = node.m_left->m_space;
-				const auto [xR, yR, wR, hR] = node.m_right->m_space;
+					if (rightCount > 1)
+						rightIndex += m_random.Get32() % rightCount;
 
-				do
+					m_pathRequests.emplace_back(Graph::FromRoom(leftIndex), Graph::FromRoom(rightIndex));
+				}
+				else
 				{
-					const Point center = xL + wL <= xR ? Point(xR, yR + n * hR / d) : Point(xR + n * wR / d, yR);
-					const int leftIndex = GetNearestRoomTo(center, node.m_left);
-					const int rightIndex = GetNearestRoomTo(center, node.m_right);
+					int n = m_input->m_extraPathCount + 1;
+					const int d = m_input->m_extraPathCount + 2;
+
+					const auto [xL, yL, wL, hL] = leftCell.m_space;
+					const auto [xR, yR, wR, hR] = rightCell.m_space;
 
-					FindPath(m_rooms.data() + leftIndex, m_rooms.data() + rightIndex);
+					do
+					{
+						const Point center = xL + wL <= xR ? Point(xR, yR + n * hR / d) : Point(xR + n * wR / d, yR);
+						const int leftIndex = GetNearestRoomTo(center, node.Left());
+						const int rightIndex = GetNearestRoomTo(center, node.Right());
+
+						m_pathRequests.emplace_back(Graph::FromRoom(leftIndex), Graph::FromRoom(rightIndex));
 
-				} while (--n > 0);
+					} while (--n > 0);
+				}
 			}
+
+			if (iter.m_counter > taskDepth)
+				continue;
+
+			if (iter.m_counter == taskDepth && taskBegin < m_pathRequests.size())
+			{
+				PathTask& task = m_pathTasks.emplace_back();
+				task.m_begin = taskBegin;
+				task.m_end = m_pathRequests.size();
+			}
+
+			taskBegin = m_pathRequests.size();
+		}
+	}
+
+	void Generator::FindPathsInParallel(size_t threadCount)
+	{
+		// Tasks are searched speculatively in rounds, each one on top of the paths committed so far.
+		// Then they are committed in the serial order, until a task turns out to have expanded a vertex
+		// whose path bits changed after it has read them. Such task starts the next round.
+		// Every round commits at least one task, and the result is identical to the serial one.
+
+		threadCount = std::min(threadCount, m_pathTasks.size());
+		if (m_pathWorkers.size() < threadCount)
+			m_pathWorkers.resize(threadCount);
+
+		for (size_t i = 0; i < threadCount; i++)
+			m_pathWorkers[i].Prepare(m_graph, m_queuePolicy);
+
+		VertexSearch search{ m_statusCounter, m_graph };
+		size_t next = 0;
+		size_t first = 0;
+
+		while (first < m_pathTasks.size())
+		{
+			// Workers can't be stopped, so cancellation is checked between rounds.
+			Report(s_pathsProgress, s_optimizeProgress, first, m_pathTasks.size());
+
+			const size_t count = std::min(threadCount, m_pathTasks.size() - first);
+			m_threadPool.Run(count, threadCount, [this, first](size_t taskIndex, size_t threadIndex) -> void
+			{
+				PathTask& task = m_pathTasks[first + taskIndex];
+				WorkerSearch& worker = m_pathWorkers[threadIndex];
+
+				task.m_visited.clear();
+				task.m_marks.clear();
+				worker.m_task = &task;
+
+				FindPaths(worker, worker.m_queues, task.m_begin, task.m_end);
+
+				for (auto& [vertex, bits] : task.m_marks)
+					bits = worker.m_states[vertex].m_path;
+
+				worker.Finish();
+			});
+
+			for (const size_t last = first + count; first < last; first++)
+			{
+				const PathTask& task = m_pathTasks[first];
+				FindPaths(search, m_vertexQueues, next, task.m_begin);
+				next = task.m_begin;
+
+				if (!CommitPathTask(task))
+					break;
+
+				next = task.m_end;
+			}
+		}
+
+		FindPaths(search, m_vertexQueues, next, m_pathRequests.size());
+	}
+
+	bool Generator::CommitPathTask(const PathTask& task)
+	{
+		for (const auto& [vertex, committed] : task.m_visited)
+		{
+			if (m_graph.m_path[vertex] != committed)
+				return false;
+		}
+
+		for (const auto& [vertex, bits] : task.m_marks)
+			m_graph.m_path[vertex] |= bits;
+
+		return true;
+	}
+
+	template <typename Search>
+	void Generator::FindPaths(Search& search, VertexQueues& queues, size_t begin, size_t end)
+	{
+		switch (m_queuePolicy)
+		{
+		case QueuePolicy::RADIX_HEAP:
+			for (size_t i = begin; i < end; i++)
+				FindPath(search, queues.m_radixHeap, m_pathRequests[i].first, m_pathRequests[i].second);
+			break;
+
+		case QueuePolicy::INDEXED_HEAP:
+			for (size_t i = begin; i < end; i++)
+				FindPath(search, queues.m_indexedHeap, m_pathRequests[i].first, m_pathRequests[i].second);
+			break;
+
+		default:
+			for (size_t i = begin; i < end; i++)
+				FindPath(search, queues.m_heap, m_pathRequests[i].first, m_pathRequests[i].second);
 		}
 	}
 
-	void Generator::FindPath(Room* const start, Room* const stop)
+	template <typename Search, typename Queue>
+	void Generator::FindPath(Search& search, Queue& queue, const uint32_t start, const uint32_t stop)
 	{
 		const float factors[2] = { 1.0f, m_input->m_pathCostFactor };
-		Vertex* vertex = start;
-		start->m_gcost = 0;
+		const uint32_t statusCounter = search.m_statusCounter;
+		const Point stopPos = m_graph.m_pos[stop];
+
+		uint32_t vertex = start;
+		search.GCost(start) = 0;
 
 		do
 		{
-			vertex->m_status = m_statusCounter + 1;
-			Room* const room = vertex->ToRoom();
+			search.Status(vertex) = statusCounter + 1;
+
+			// Room's edges start at its entrances. Rooms are never linked to each other.
+
+			const uint8_t path = search.Visit(vertex);
+			const float gcost = search.GCost(vertex);
+			const Point pos = m_graph.m_pos[vertex];
+			const uint32_t* const links = m_graph.Links(vertex);
+			const Point* const entrances = m_graph.IsRoom(vertex) ? m_rooms[Graph::ToRoom(vertex)].m_entrances : nullptr;
 
 			for (uint8_t i = 0; i < 4; i++)
 			{
-				Vertex* const adjacent = vertex->m_links[i];
-				if (adjacent->m_status > m_statusCounter)
+				const uint32_t adjacent = links[i];
+				uint32_t& adjStatus = search.Status(adjacent);
+
+				if (adjStatus > statusCounter)
 					continue;
 
 				Point p1, p2;
-				if (room == nullptr)
+				if (entrances == nullptr)
 				{
-					Room* const adjRoom = adjacent->ToRoom();
-
-					p1 = vertex->m_pos;
-					p2 = (adjRoom != nullptr) ? adjRoom->m_entrances[i ^ 0b10] : adjacent->m_pos;
+					p1 = pos;
+					p2 = m_graph.IsRoom(adjacent) ? m_rooms[Graph::ToRoom(adjacent)].m_entrances[i ^ 0b10] : m_graph.m_pos[adjacent];
 				}
 				else
 				{
-					p1 = adjacent->m_pos;
-					p2 = room->m_entrances[i];
+					p1 = m_graph.m_pos[adjacent];
+					p2 = entrances[i];
 				}
 
 				const float diff = static_cast<float>(std::abs(p1.x - p2.x) + std::abs(p1.y - p2.y));
-				const float newGCost = vertex->m_gcost + diff * factors[(vertex->m_path >> i) & 1];
+				const float newGCost = gcost + diff * factors[(path >> i) & 1];
 
-				if (adjacent->m_status < m_statusCounter)
+				if (adjStatus < statusCounter)
 				{
-					const int dx = stop->m_pos.x - adjacent->m_pos.x;
-					const int dy = stop->m_pos.y - adjacent->m_pos.y;
+					const int dx = stopPos.x - m_graph.m_pos[adjacent].x;
+					const int dy = stopPos.y - m_graph.m_pos[adjacent].y;
 
 					const float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
+					const float hcost = dist * m_input->m_heuristicFactor;
 
-					adjacent->m_hcost = dist * m_input->m_heuristicFactor;
-					adjacent->m_status = m_statusCounter;
-					adjacent->m_origin = i;
-					adjacent->m_gcost = newGCost;
+					search.HCost(adjacent) = hcost;
+					search.Origin(adjacent) = i;
+					search.GCost(adjacent) = newGCost;
+					adjStatus = statusCounter;
 
-					m_vertexHeap.Push(newGCost + adjacent->m_hcost, adjacent);
+					queue.Push(newGCost + hcost, adjacent);
 				}
-				else if (newGCost < adjacent->m_gcost)
+				else if (float& adjGCost = search.GCost(adjacent); newGCost < adjGCost)
 				{
-					adjacent->m_origin = i;
-					adjacent->m_gcost = newGCost;
+					search.Origin(adjacent) = i;
+					adjGCost = newGCost;
 
-					m_vertexHeap.Push(newGCost + adjacent->m_hcost, adjacent);
+					if constexpr (std::is_same_v<Queue, IndexedMinHeap<float>>)
+						queue.DecreaseKey(newGCost + search.HCost(adjacent), adjacent);
+					else
+						queue.Push(newGCost + search.HCost(adjacent), adjacent);
 				}
 			}
 
 			do
 			{
-				vertex = m_vertexHeap.TopObject();
-				m_vertexHeap.Pop();
+				vertex = queue.TopObject();
+				queue.Pop();
 
-			} while (vertex->m_status > m_statusCounter);
+			} while (search.Status(vertex) > statusCounter);
 
 		} while (vertex != stop);
 
-		m_statusCounter += 2;
-		m_vertexHeap.Clear();
+		search.m_statusCounter += 2;
+		queue.Clear();
 
 		do
 		{
-			const uint8_t origin = vertex->m_origin;
+			const uint8_t origin = search.Origin(vertex);
 			const uint8_t realOrigin = origin ^ 0b10;
 
-			vertex->m_path |= 1 << realOrigin;
-			vertex = vertex->m_links[realOrigin];
-			vertex->m_path |= 1 << origin;
+			search.Mark(vertex, static_cast<uint8_t>(1 << realOrigin));
+			vertex = m_graph.Links(vertex)[realOrigin];
+			search.Mark(vertex, static_cast<uint8_t>(1 << origin));
 
 		} while (vertex != start);
 	}
@@ -602,33 +1281,34 @@ namespace dg::impl
 		const uint8_t maskEW = m_input->m_generateFewerPaths ? 0b1010 : 0b1111;
 		const uint8_t maskNS = m_input->m_generateFewerPaths ? 0b0101 : 0b1111;
 
-		for (Vertex& vertex : m_vertices)
+		const uint32_t size = static_cast<uint32_t>(m_graph.Size());
+		for (uint32_t vertex = m_graph.VertexBegin(); vertex < size; vertex++)
 		{
-			uint8_t& path = vertex.m_path;
-			Vertex** links = vertex.m_links;
+			uint8_t& path = m_graph.m_path[vertex];
+			uint32_t* const links = m_graph.Links(vertex);
 
 			if (path == 0)
 			{
-				vertex.Unlink();
+				m_graph.Unlink(vertex);
 				continue;
 			}
 
 			if ((path & maskEW) == 0b1010)
 			{
-				Vertex* const east = links[Dir::EAST];
-				Vertex* const west = links[Dir::WEST];
+				const uint32_t east = links[Dir::EAST];
+				const uint32_t west = links[Dir::WEST];
 
-				if (east->ToRoom() == nullptr || west->ToRoom() == nullptr)
+				if (!m_graph.IsRoom(east) || !m_graph.IsRoom(west))
 				{
-					east->m_links[Dir::WEST] = west;
-					west->m_links[Dir::EAST] = east;
+					m_graph.Links(east)[Dir::WEST] = west;
+					m_graph.Links(west)[Dir::EAST] = east;
 
-					links[Dir::EAST] = &Vertex::s_sentinel;
-					links[Dir::WEST] = &Vertex::s_sentinel;
+					links[Dir::EAST] = Graph::s_sentinel;
+					links[Dir::WEST] = Graph::s_sentinel;
 
 					if (path &= ~0b1010; path == 0)
 					{
-						vertex.Unlink();
+						m_graph.Unlink(vertex);
 						continue;
 					}
 				}
@@ -636,20 +1316,20 @@ namespace dg::impl
 
 			if ((path & maskNS) == 0b0101)
 			{
-				Vertex* const north = links[Dir::NORTH];
-				Vertex* const south = links[Dir::SOUTH];
+				const uint32_t north = links[Dir::NORTH];
+				const uint32_t south = links[Dir::SOUTH];
 
-				if (north->ToRoom() == nullptr || south->ToRoom() == nullptr)
+				if (!m_graph.IsRoom(north) || !m_graph.IsRoom(south))
 				{
-					north->m_links[Dir::SOUTH] = south;
-					south->m_links[Dir::NORTH] = north;
+					m_graph.Links(north)[Dir::SOUTH] = south;
+					m_graph.Links(south)[Dir::NORTH] = north;
 
-					links[Dir::NORTH] = &Vertex::s_sentinel;
-					links[Dir::SOUTH] = &Vertex::s_sentinel;
+					links[Dir::NORTH] = Graph::s_sentinel;
+					links[Dir::SOUTH] = Graph::s_sentinel;
 
 					if (path &= ~0b0101; path == 0)
 					{
-						vertex.Unlink();
+						m_graph.Unlink(vertex);
 						continue;
 					}
 				}
@@ -662,121 +1342,182 @@ namespace dg::impl
 	void Generator::GenerateOutput()
 	{
 		int ne = 0; int sw = 0;
-		for (const Room& room : m_rooms)
+		for (size_t i = 0; i < m_rooms.size(); i++)
 		{
-			ne += ((room.m_path >> Dir::NORTH) & 1) + ((room.m_path >> Dir::EAST) & 1);
-			sw += ((room.m_path >> Dir::SOUTH) & 1) + ((room.m_path >> Dir::WEST) & 1);
+			const uint8_t path = m_graph.m_path[Graph::FromRoom(i)];
+
+			ne += ((path >> Dir::NORTH) & 1) + ((path >> Dir::EAST) & 1);
+			sw += ((path >> Dir::SOUTH) & 1) + ((path >> Dir::WEST) & 1);
 		}
 
 		m_output->m_paths.reserve(static_cast<size_t>(ne) + static_cast<size_t>(m_partialPathCount));
 		m_output->m_entrances.reserve(static_cast<size_t>(ne) + static_cast<size_t>(sw));
 
-		for (Room& room : m_rooms)
+		for (size_t i = 0; i < m_rooms.size(); i++)
 		{
-			if (room.m_path & (1 << Dir::NORTH))
+			const Room& room = m_rooms[i];
+			const uint32_t vertex = Graph::FromRoom(i);
+
+			const uint8_t path = m_graph.m_path[vertex];
+			const uint32_t* const links = m_graph.Links(vertex);
+
+			if (path & (1 << Dir::NORTH))
 			{
 				const Point ent = room.m_entrances[Dir::NORTH];
-				const Point ext = room.m_links[Dir::NORTH]->m_pos;
+				const Point ext = m_graph.m_pos[links[Dir::NORTH]];
 
 				m_output->m_entrances.emplace_back(ent);
 				m_output->m_paths.emplace_back(ext, Vec(0, ent.y - ext.y));
 			}
 
-			if (room.m_path & (1 << Dir::EAST))
+			if (path & (1 << Dir::EAST))
 			{
 				const Point ent = room.m_entrances[Dir::EAST];
-				const Point ext = room.m_links[Dir::EAST]->m_pos;
+				const Point ext = m_graph.m_pos[links[Dir::EAST]];
 
 				m_output->m_entrances.emplace_back(ent);
 				m_output->m_paths.emplace_back(ext, Vec(ent.x - ext.x, 0));
 			}
 
-			if (room.m_path & (1 << Dir::SOUTH))
+			if (path & (1 << Dir::SOUTH))
 			{
 				const Point ent = room.m_entrances[Dir::SOUTH];
-				const Point ext = room.m_links[Dir::SOUTH]->m_pos;
+				const Point ext = m_graph.m_pos[links[Dir::SOUTH]];
 
 				m_output->m_entrances.emplace_back(ent);
 				m_output->m_paths.emplace_back(ext, Vec(0, ent.y - ext.y));
 
-				room.m_links[Dir::SOUTH]->m_path &= ~(1 << Dir::NORTH);
+				m_graph.m_path[links[Dir::SOUTH]] &= ~(1 << Dir::NORTH);
 			}
 
-			if (room.m_path & (1 << Dir::WEST))
+			if (path & (1 << Dir::WEST))
 			{
 				const Point ent = room.m_entrances[Dir::WEST];
-				const Point ext = room.m_links[Dir::WEST]->m_pos;
+				const Point ext = m_graph.m_pos[links[Dir::WEST]];
 
 				m_output->m_entrances.emplace_back(ent);
 				m_output->m_paths.emplace_back(ext, Vec(ent.x - ext.x, 0));
 
-				room.m_links[Dir::WEST]->m_path &= ~(1 << Dir::EAST);
+				m_graph.m_path[links[Dir::WEST]] &= ~(1 << Dir::EAST);
 			}
 		}
 
-		for (const Vertex& vertex : m_vertices)
+		const uint32_t size = static_cast<uint32_t>(m_graph.Size());
+		for (uint32_t vertex = m_graph.VertexBegin(); vertex < size; vertex++)
 		{
-			const auto& [xCrr, yCrr] = vertex.m_pos;
-			if (vertex.m_path & (1 << Dir::NORTH))
+			const uint8_t path = m_graph.m_path[vertex];
+			const uint32_t* const links = m_graph.Links(vertex);
+
+			const auto& [xCrr, yCrr] = m_graph.m_pos[vertex];
+			if (path & (1 << Dir::NORTH))
 			{
-				const auto [xAdj, yAdj] = vertex.m_links[Dir::NORTH]->m_pos;
+				const auto [xAdj, yAdj] = m_graph.m_pos[links[Dir::NORTH]];
 				m_output->m_paths.emplace_back(Point(xCrr, yCrr), Vec(xAdj - xCrr, yAdj - yCrr));
 			}
 
-			if (vertex.m_path & (1 << Dir::EAST))
+			if (path & (1 << Dir::EAST))
 			{
-				const auto [xAdj, yAdj] = vertex.m_links[Dir::EAST]->m_pos;
+				const auto [xAdj, yAdj] = m_graph.m_pos[links[Dir::EAST]];
 				m_output->m_paths.emplace_back(Point(xCrr, yCrr), Vec(xAdj - xCrr, yAdj - yCrr));
 			}
 		}
 	}
 
-	void Generator::DeleteTree(Node<Cell>* node)
+	int Generator::GetNearestRoomTo(const Point point, uint32_t index) const
 	{
-		if (node->m_left == nullptr)
-			return;
-
-		DeleteTree(node->m_right);
-		node->m_right->~Node<Cell>();
+		const Tree<Cell>::Node& node = m_tree[index];
+		if (node.IsLeaf())
+			return node.m_roomOffset;
 
-		DeleteTree(node->m_left);
-		node->m_left->~Node<Cell>();
-
-		operator delete[](node->m_left);
-	}
-
-	int Generator::GetNearestRoomTo(const Point point, Node<Cell>* node)
-	{
-		if (node->m_left == nullptr)
-			return node->m_roomOffset;
-
-		const auto [xL, yL, wL, hL] = node->m_left->m_space;
-		const auto [xR, yR, wR, hR] = node->m_right->m_space;
+		const auto [xL, yL, wL, hL] = m_tree[node.Left()].m_space;
+		const auto [xR, yR, wR, hR] = m_tree[node.Right()].m_space;
 
 		const int l = std::abs(xL + (wL >> 1) - point.x) + std::abs(yL + (hL >> 1) - point.y);
 		const int r = std::abs(xR + (wR >> 1) - point.x) + std::abs(yR + (hR >> 1) - point.y);
 
 		static constexpr int s_maxOffset = std::numeric_limits<int>::max();
-		Node<Cell>* const nextNodes[2] = { node->m_left, node->m_right };
+		const uint32_t nextNodes[2] = { node.Left(), node.Right() };
 
 		const int offset = GetNearestRoomTo(point, nextNodes[l > r]);
 		return offset != s_maxOffset ? offset : GetNearestRoomTo(point, nextNodes[l <= r]);
 	}
 
+	size_t Generator::GetNodeLimit(const Rect& space, int left) const
+	{
+		// Every leaf is at least m_minSpaceSize wide and high, which limits the number of nodes
+		// more tightly than the depth does on small spaces. The tree never exceeds this capacity.
+
+		const size_t depthLimit = (static_cast<size_t>(2) << std::min(left, 62)) - 1;
+		const size_t xLeaves = static_cast<size_t>(space.w / m_minSpaceSize);
+		const size_t yLeaves = static_cast<size_t>(space.h / m_minSpaceSize);
+
+		return std::min(depthLimit, (xLeaves * yLeaves << 1) - 1);
+	}
+
 	void Generator::Generate(const Input* input, Output* output)
 	{
 		m_input = input;
 		m_output = output;
 
-		Clear();
 		Verify();
-		Prepare();
-		GenerateTree(*m_rootNode, m_input->m_maxDepth);
-		GenerateRooms();
-		CreateVertices();
-		FindPaths();
-		OptimizeVertices();
-		GenerateOutput();
+
+		// Stages before the first one affected by the changed parameters are skipped, if their results were retained.
+		const Stage stage = GetFirstStage();
+		m_retained.m_valid = false;
+
+		try
+		{
+			if (stage == Stage::TREE)
+			{
+				Report(0.0f);
+				Clear();
+				Prepare();
+				GenerateTree();
+				Report(s_roomsProgress);
+				GenerateRooms();
+				Report(s_verticesProgress);
+				CreateVertices();
+
+				if (m_retainState)
+				{
+					m_retained.m_random = m_random;
+					m_retained.m_rooms = m_output->m_rooms;
+					m_retained.m_links = m_graph.m_links;
+				}
+			}
+			else
+			{
+				Report(s_pathsProgress);
+				Restore(stage);
+			}
+
+			if (stage != Stage::OPTIMIZE)
+			{
+				FindPaths();
+
+				if (m_retainState)
+					m_retained.m_paths = m_graph.m_path;
+			}
+
+			Report(s_optimizeProgress);
+			OptimizeVertices();
+			Report(s_outputProgress);
+			GenerateOutput();
+			Report(1.0f);
+		}
+		catch (const CancelledError&)
+		{
+			// Work of a cancelled run is useless, so its memory is freed right away.
+			Release();
+			*m_output = Output();
+			throw;
+		}
+
+		if (m_retainState)
+		{
+			m_retained.m_input = *m_input;
+			m_retained.m_valid = true;
+		}
 	}
 }
 
@@ -804,13 +1545,106 @@ namespace dg
 		in.m_extraPathCount = 2;
 		in.m_extraPathDepth = 2;
 		in.m_generateFewerPaths = true;
+		in.m_parallelDepth = 0;
+		in.m_threadCount = 0;
 
 		return in;
 	}
 
+	Context::Context() : m_generator(new impl::Generator()) { m_generator->m_retainState = true; }
+	Context::~Context() { delete m_generator; }
+
+	Context::Context(Context&& ref) noexcept : m_generator(std::exchange(ref.m_generator, nullptr)) {}
+
+	Context& Context::operator=(Context&& ref) noexcept
+	{
+		if (&ref == this)
+			return *this;
+
+		delete m_generator;
+		m_generator = std::exchange(ref.m_generator, nullptr);
+
+		return *this;
+	}
+
+	impl::Generator& Context::Access()
+	{
+		// Moved-from context gets a new generator on its first use.
+		if (m_generator == nullptr)
+		{
+			m_generator = new impl::Generator();
+			m_generator->m_retainState = true;
+		}
+
+		return *m_generator;
+	}
+
+	void Context::Generate(const Input* input, Output* output)
+	{
+		Access().Generate(input, output);
+	}
+
+	void Context::Release()
+	{
+		if (m_generator != nullptr)
+			m_generator->Release();
+	}
+
+	void Context::SetCancellationToken(const CancellationToken* token)
+	{
+		Access().m_cancellation = token;
+	}
+
+	void Context::SetProgressCallback(ProgressCallback callback, void* data)
+	{
+		impl::Generator& generator = Access();
+
+		generator.m_progressCallback = callback;
+		generator.m_progressData = data;
+	}
+
+	void Context::SetSpeculativePaths(bool enabled)
+	{
+		Access().m_speculativePaths = enabled;
+	}
+
 	void Generate(const Input* input, Output* output)
 	{
 		impl::Generator generator;
 		generator.Generate(input, output);
 	}
+
+	void GenerateBatch(const Input* input, const std::uint64_t* seeds, std::size_t count, Output* outputs, int threadCount)
+	{
+		if (input == nullptr)
+			throw std::runtime_error("Pointer to the dg::Input object was null");
+
+		if (count == 0)
+			return;
+
+		if (seeds == nullptr)
+			throw std::runtime_error("Pointer to the seed array was null");
+
+		if (outputs == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output array was null");
+
+		if (threadCount < 0)
+			throw std::runtime_error("Thread count was negative");
+
+		// Dungeons are independent, so threads are spent on them rather than inside the generator.
+		const size_t workerCount = std::min(impl::ThreadPool::GetThreadCount(threadCount), count);
+
+		std::unique_ptr<impl::Generator[]> generators(new impl::Generator[workerCount]);
+		std::vector<Input> inputs(workerCount, *input);
+
+		for (Input& workerInput : inputs)
+			workerInput.m_threadCount = 1;
+
+		impl::ThreadPool threadPool;
+		threadPool.Run(count, workerCount, [seeds, outputs, &generators, &inputs](size_t task, size_t thread) -> void
+		{
+			inputs[thread].m_seed = seeds[task];
+			generators[thread].Generate(&inputs[thread], outputs + task);
+		});
+	}
 }
\ No newline at end of file
@@ -6,7 +6,9 @@
 #include "../include/dgen/dgen.hpp"
 #include "bin_tree.hpp"
 #include "heap.hpp"
+#include "radix_heap.hpp"
 #include "rand.hpp"
+#include "thread_pool.hpp"
 
 #include <limits>
 #include <vector>
@@ -16,6 +18,12 @@ namespace dg::impl
 	struct Room;
 	enum Dir { NORTH, EAST, SOUTH, WEST };
 
+	// Queues order vertices with equal keys differently, so only BINARY_HEAP reproduces the maps of Generate.
+	// INDEXED_HEAP finds equally short paths, which on large maps sometimes run elsewhere. RADIX_HEAP changes
+	// the search itself, since the heuristic isn't monotone and keys below the last extracted one are raised to it.
+	enum class QueuePolicy { BINARY_HEAP, RADIX_HEAP, INDEXED_HEAP };
+	enum class Stage { TREE, PATHS, OPTIMIZE };
+
 	struct Cell
 	{
 		enum Flag : uint32_t { RANDOM_PATH, SPARSE_AREA, GENERATE_ROOMS, CONNECT_ROOMS };
@@ -30,26 +38,38 @@ namespace dg::impl
 		Cell(int w, int h) : m_space(0, 0, w, h) {}
 	};
 
-	struct Vertex
+	struct Graph
 	{
-		static Vertex s_sentinel;
-
-		float m_gcost = 0;
-		float m_hcost = 0;
-
-		uint8_t m_path = 0;
-		uint8_t m_origin = 0;
-		uint32_t m_status = 0;
+		// Vertex 0 is the sentinel, which stands for a missing link. It's followed by rooms and then by plain vertices.
 
-		Point m_pos{};
-		Vertex* m_links[4]{ &s_sentinel, &s_sentinel, &s_sentinel, &s_sentinel };
+		static constexpr uint32_t s_sentinel = 0;
 
-		Vertex() = default;
-		Vertex(uint32_t status) : m_status(status) {}
-		virtual ~Vertex() {}
+		std::vector<Point> m_pos;
+		std::vector<uint32_t> m_links;
+		std::vector<float> m_gcost;
+		std::vector<float> m_hcost;
+		std::vector<uint32_t> m_status;
+		std::vector<uint8_t> m_origin;
+		std::vector<uint8_t> m_path;
+		uint32_t m_roomCount = 0;
 
-		void Unlink();
-		virtual Room* ToRoom() { return nullptr; }
+		void Clear();
+		void Reset();
+		void Prepare(size_t roomCount);
+		void Resize(size_t size);
+		void Restore(const std::vector<uint32_t>& links);
+		void Unlink(uint32_t vertex);
+		uint32_t AddRoom(Point pos);
+
+		size_t Size() const { return m_pos.size(); }
+		uint32_t VertexBegin() const { return m_roomCount + 1; }
+		bool IsRoom(uint32_t vertex) const { return vertex - 1 < m_roomCount; }
+
+		uint32_t* Links(uint32_t vertex) { return m_links.data() + (static_cast<size_t>(vertex) << 2); }
+		const uint32_t* Links(uint32_t vertex) const { return m_links.data() + (static_cast<size_t>(vertex) << 2); }
+
+		static uint32_t FromRoom(size_t room) { return static_cast<uint32_t>(room + 1); }
+		static size_t ToRoom(uint32_t vertex) { return static_cast<size_t>(vertex) - 1; }
 	};
 
 	struct Tag
@@ -64,11 +84,7 @@ namespace dg::impl
 			uint64_t m_hasIndex : 1;
 		};
 
-		union
-		{
-			Data m_data{};
-			Vertex* m_vertex;
-		};
+		Data m_data{};
 
 		Tag() = default;
 		Tag(int high, int low);
@@ -77,23 +93,140 @@ namespace dg::impl
 
 	struct RadixSort
 	{
+		static constexpr size_t s_countSize = static_cast<size_t>(6) << 11;
+		static constexpr size_t s_parallelThreshold = 1 << 18;
+
 		void* const m_memory;
+		ThreadPool* const m_threadPool;
+		const size_t m_threadCount;
 
-		RadixSort(const size_t maxSize);
+		RadixSort(const size_t maxSize, ThreadPool* threadPool = nullptr, size_t threadCount = 1);
 		~RadixSort();
 
 		void Sort(Tag* arr, const size_t size) const;
+		void Sort(Tag* arr, const size_t size, const size_t columns, const size_t rows) const;
+		size_t GetChunkCount(const size_t size) const;
+
+		template <int digitBits>
+		void SortDigits(Tag* arr, const size_t size, const uint64_t mask) const;
+
+		template <int digitBits>
+		Tag* SortDigitsInParallel(Tag* arr, Tag* temp, const size_t size, const int* shifts, int passes) const;
+
+		template <int digitBits>
+		static int CountDigits(const uint64_t mask);
 	};
 
-	struct Room final : public Vertex
+	struct Room
 	{
-		Node<Cell>& m_node;
+		uint32_t m_node;
 		Point m_entrances[4]{};
 		size_t m_rectBegin = 0;
 		size_t m_rectEnd = 0;
 
-		Room(Node<Cell>& node) : m_node(node) {}
-		Room* ToRoom() override { return this; }
+		Room(uint32_t node) : m_node(node) {}
+	};
+
+	struct VertexQueues
+	{
+		MinHeap<float, uint32_t> m_heap;
+		RadixHeap<uint32_t> m_radixHeap;
+		IndexedMinHeap<float> m_indexedHeap;
+
+		void Clear();
+		void Reset();
+	};
+
+	struct SearchState
+	{
+		float m_gcost = 0;
+		float m_hcost = 0;
+
+		uint32_t m_status = 0;
+		uint8_t m_origin = 0;
+		uint8_t m_path = 0;
+	};
+
+	struct VertexSearch
+	{
+		uint32_t& m_statusCounter;
+		Graph& m_graph;
+
+		float& GCost(uint32_t vertex) { return m_graph.m_gcost[vertex]; }
+		float& HCost(uint32_t vertex) { return m_graph.m_hcost[vertex]; }
+		uint32_t& Status(uint32_t vertex) { return m_graph.m_status[vertex]; }
+		uint8_t& Origin(uint32_t vertex) { return m_graph.m_origin[vertex]; }
+
+		uint8_t Visit(uint32_t vertex) { return m_graph.m_path[vertex]; }
+		void Mark(uint32_t vertex, uint8_t bits) { m_graph.m_path[vertex] |= bits; }
+	};
+
+	struct PathTask
+	{
+		size_t m_begin = 0;
+		size_t m_end = 0;
+
+		std::vector<std::pair<uint32_t, uint8_t>> m_visited;
+		std::vector<std::pair<uint32_t, uint8_t>> m_marks;
+	};
+
+	struct WorkerSearch
+	{
+		uint32_t m_statusCounter = 1;
+		VertexQueues m_queues;
+
+		PathTask* m_task = nullptr;
+		const Graph* m_graph = nullptr;
+		std::vector<SearchState> m_states;
+
+		void Prepare(const Graph& graph, QueuePolicy policy);
+		void Finish();
+
+		float& GCost(uint32_t vertex) { return m_states[vertex].m_gcost; }
+		float& HCost(uint32_t vertex) { return m_states[vertex].m_hcost; }
+		uint32_t& Status(uint32_t vertex) { return m_states[vertex].m_status; }
+		uint8_t& Origin(uint32_t vertex) { return m_states[vertex].m_origin; }
+
+		uint8_t Visit(uint32_t vertex);
+		void Mark(uint32_t vertex, uint8_t bits);
+	};
+
+	struct TreeState
+	{
+		Tree<Cell>& m_tree;
+		std::vector<Tag>& m_tags;
+		Random& m_random;
+
+		int m_targetDepth = 0;
+		int m_roomCount = 0;
+		int m_branchLeft = -1;
+	};
+
+	struct Branch
+	{
+		Random m_random;
+		Tree<Cell> m_tree;
+		std::vector<Tag> m_tags;
+
+		uint32_t m_index = 0;
+		uint32_t m_flags = 0;
+		int m_targetDepth = 0;
+		int m_roomCount = 0;
+	};
+
+	struct RetainedState
+	{
+		// Snapshot of the graph taken before paths are searched, together with the input it was made for.
+
+		bool m_valid = false;
+		Input m_input{};
+		Random m_random;
+
+		std::vector<Rect> m_rooms;
+		std::vector<uint32_t> m_links;
+		std::vector<uint8_t> m_paths;
+
+		void Reset();
 	};
 
 	struct Generator
@@ -102,7 +235,7 @@ namespace dg::impl
 		int m_spaceShrink = 0;
 
 		int m_deltaDepth = 0;
-		int m_targetDepth = 0;
+		int m_branchLeft = -1;
 		int m_minSpaceSize = 0;
 		int m_randPathDepth = 0;
 		float m_minSpaceRand = 0;
@@ -116,32 +249,92 @@ namespace dg::impl
 
 		std::vector<Tag> m_tags;
 		std::vector<Room> m_rooms;
-		std::vector<Vertex> m_vertices;
+		Graph m_graph;
 
 		Random m_random;
-		Node<Cell>* m_rootNode = nullptr;
-		MinHeap<float, Vertex*> m_vertexHeap;
+		Tree<Cell> m_tree;
+		VertexQueues m_vertexQueues;
+		QueuePolicy m_queuePolicy = QueuePolicy::BINARY_HEAP;
+		bool m_speculativePaths = false;
+
+		size_t m_branchCount = 0;
+		std::vector<Branch> m_branches;
+		ThreadPool m_threadPool;
+
+		std::vector<PathTask> m_pathTasks;
+		std::vector<WorkerSearch> m_pathWorkers;
+		std::vector<std::pair<uint32_t, uint32_t>> m_pathRequests;
+
+		bool m_retainState = false;
+		RetainedState m_retained;
+
+		const CancellationToken* m_cancellation = nullptr;
+		ProgressCallback m_progressCallback = nullptr;
+		void* m_progressData = nullptr;
 
 		static constexpr int s_roomSizeLimit = 4;
+		static constexpr int s_pathTasksPerThread = 8;
+		static constexpr size_t s_parallelPathThreshold = 1 << 15;
+		static constexpr size_t s_vertexCheckInterval = 1 << 14;
+		static constexpr size_t s_pathCheckInterval = 1 << 4;
+
+		// Rough shares of the generation time taken by the stages before each of these ones.
+		static constexpr float s_roomsProgress = 0.05f;
+		static constexpr float s_verticesProgress = 0.12f;
+		static constexpr float s_pathsProgress = 0.25f;
+		static constexpr float s_optimizeProgress = 0.95f;
+		static constexpr float s_outputProgress = 0.975f;
 
 		void Clear();
+		void Release();
 		void Verify();
+		Stage GetFirstStage() const;
 		void Prepare();
-		uint32_t GenerateTree(Node<Cell>& node, int left);
-		uint32_t MakeLeafCell(Node<Cell>& node);
+		void Restore(Stage stage);
+		void GenerateTree();
+		uint32_t GenerateTree(TreeState& state, uint32_t index, int left);
+		uint32_t MakeLeafCell(TreeState& state, Tree<Cell>::Node& node);
+		void AddBranch(uint32_t index, int targetDepth);
+		void GenerateBranch(Branch& branch, int left);
+		uint32_t AttachBranches(uint32_t index, int left, size_t& branchIndex);
 		void GenerateRooms();
 		void CreateVertices();
 		void FindPaths();
-		void FindPath(Room* const start, Room* const stop);
+		void CollectPaths(int taskDepth);
+		void FindPathsInParallel(size_t threadCount);
+		bool CommitPathTask(const PathTask& task);
+
+		template <typename Search>
+		void FindPaths(Search& search, VertexQueues& queues, size_t begin, size_t end);
+
+		template <typename Search, typename Queue>
+		void FindPath(Search& search, Queue& queue, const uint32_t start, const uint32_t stop);
 		void OptimizeVertices();
 		void GenerateOutput();
+		int GetNearestRoomTo(const Point point, uint32_t index) const;
+		size_t GetNodeLimit(const Rect& space, int left) const;
 
-		static void DeleteTree(Node<Cell>* node);
-		static int GetNearestRoomTo(const Point point, Node<Cell>* node);
+		void Report(float progress) const;
+		void Report(float from, float to, size_t done, size_t total) const;
 
 		Generator() = default;
 		~Generator() { Clear(); }
 
 		void Generate(const Input* input, Output* output);
 	};
+
+	inline void Generator::Report(float progress) const
+	{
+		if (m_cancellation != nullptr && m_cancellation->IsCancelled())
+			throw CancelledError();
+
+		if (m_progressCallback != nullptr && !m_progressCallback(progress, m_progressData))
+			throw CancelledError();
+	}
+
+	inline void Generator::Report(float from, float to, size_t done, size_t total) const
+	{
+		if (m_cancellation != nullptr || m_progressCallback != nullptr)
+			Report(from + (to - from) * static_cast<float>(done) / static_cast<float>(total));
+	}
 }
\ No newline at end of file
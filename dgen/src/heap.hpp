@@ -3,8 +3,11 @@
 
 #pragma once
 #include <algorithm>
+#include <limits>
 #include <utility>
+#include <vector>
 #include <stddef.h>
+#include <stdint.h>
 
 namespace dg::impl
 {
@@ -52,6 +55,41 @@ namespace dg::impl
 	template <typename KeyType, typename ObjType>
 	using MaxHeap = Heap<KeyType, ObjType, true>;
 
+	template <typename KeyType, size_t arity = 4>
+	class IndexedMinHeap
+	{
+		// Objects are dense indices lower than the count passed to Resize. Heap slot of every object is tracked,
+		// so each object is stored at most once and its key can be decreased in place.
+
+	public:
+		using pair_type = std::pair<KeyType, uint32_t>;
+		static constexpr uint32_t s_none = std::numeric_limits<uint32_t>::max();
+
+	private:
+		std::vector<pair_type> m_data;
+		std::vector<uint32_t> m_slots;
+
+		void SiftUp(size_t index);
+		void SiftDown(size_t index);
+		void Place(size_t index, const pair_type& pair);
+
+		static_assert(arity >= 2);
+
+	public:
+		void Clear();
+		void Reset();
+		void Resize(size_t objectCount);
+
+		void Pop();
+		void Push(KeyType key, uint32_t object);
+		void DecreaseKey(KeyType key, uint32_t object);
+
+		size_t Size() const { return m_data.size(); }
+		bool Contains(uint32_t object) const { return m_slots[object] != s_none; }
+		KeyType TopKey() const { return m_data.front().first; }
+		uint32_t TopObject() const { return m_data.front().second; }
+	};
+
 	template <typename KeyType, typename ObjType, bool maxHeap>
 	void Heap<KeyType, ObjType, maxHeap>::Reallocate()
 	{
@@ -258,4 +296,124 @@ namespace dg::impl
 			std::swap(crrPair, parPair);
 		}
 	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::SiftUp(size_t index)
+	{
+		const pair_type pair = m_data[index];
+
+		while (index > 0)
+		{
+			const size_t parIndex = (index - 1) / arity;
+			if (!(pair.first < m_data[parIndex].first))
+				break;
+
+			Place(index, m_data[parIndex]);
+			index = parIndex;
+		}
+
+		Place(index, pair);
+	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::SiftDown(size_t index)
+	{
+		const pair_type pair = m_data[index];
+		const size_t size = m_data.size();
+
+		while (true)
+		{
+			const size_t firstIndex = index * arity + 1;
+			if (firstIndex >= size) break;
+
+			const size_t lastIndex = std::min(firstIndex + arity, size);
+			size_t chdIndex = firstIndex;
+
+			for (size_t i = firstIndex + 1; i < lastIndex; i++)
+			{
+				if (m_data[i].first < m_data[chdIndex].first)
+					chdIndex = i;
+			}
+
+			if (!(m_data[chdIndex].first < pair.first))
+				break;
+
+			Place(index, m_data[chdIndex]);
+			index = chdIndex;
+		}
+
+		Place(index, pair);
+	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::Place(size_t index, const pair_type& pair)
+	{
+		m_data[index] = pair;
+		m_slots[pair.second] = static_cast<uint32_t>(index);
+	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::Clear()
+	{
+		for (const pair_type& pair : m_data)
+			m_slots[pair.second] = s_none;
+
+		m_data.clear();
+	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::Reset()
+	{
+		std::vector<pair_type>().swap(m_data);
+		std::vector<uint32_t>().swap(m_slots);
+	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::Resize(size_t objectCount)
+	{
+		m_data.clear();
+		m_slots.assign(objectCount, s_none);
+	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::Pop()
+	{
+		if (m_data.empty())
+			return;
+
+		m_slots[m_data.front().second] = s_none;
+
+		const pair_type last = m_data.back();
+		m_data.pop_back();
+
+		if (!m_data.empty())
+		{
+			m_data.front() = last;
+			SiftDown(0);
+		}
+	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::Push(KeyType key, uint32_t object)
+	{
+		if (Contains(object))
+		{
+			DecreaseKey(key, object);
+			return;
+		}
+
+		m_data.emplace_back(key, object);
+		SiftUp(m_data.size() - 1);
+	}
+
+	template <typename KeyType, size_t arity>
+	void IndexedMinHeap<KeyType, arity>::DecreaseKey(KeyType key, uint32_t object)
+	{
+		const size_t index = m_slots[object];
+		if (!(key < m_data[index].first))
+			return;
+
+		m_data[index].first = key;
+		SiftUp(index);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace dg::impl
+{
+	template <typename ObjType>
+	class RadixHeap
+	{
+		// Monotone priority queue for non-negative float keys. Bit patterns of such floats are ordered like the
+		// floats themselves, so elements are bucketed by the highest bit in which they differ from the last
+		// extracted key. Keys lower than the last extracted one are raised to it, so with non-monotone keys
+		// elements come out in a different order than from an exact priority queue.
+
+	public:
+		using pair_type = std::pair<uint32_t, ObjType>;
+
+	private:
+		static constexpr size_t s_bucketCount = 33;
+
+		std::vector<pair_type> m_buckets[s_bucketCount];
+		uint64_t m_mask = 0;
+		uint32_t m_last = 0;
+		size_t m_size = 0;
+
+		void Refill();
+		size_t GetBucket(uint32_t bits) const;
+
+		static uint32_t ToBits(float key);
+		static float ToKey(uint32_t bits);
+
+	public:
+		void Clear();
+		void Reset();
+
+		void Pop();
+		void Push(float key, const ObjType& object);
+
+		size_t Size() const { return m_size; }
+		float TopKey() const { return ToKey(m_last); }
+		const ObjType& TopObject() const { return m_buckets[0].back().second; }
+	};
+
+	template <typename ObjType>
+	void RadixHeap<ObjType>::Refill()
+	{
+		size_t index = 1;
+		while ((m_mask & (static_cast<uint64_t>(1) << index)) == 0)
+			index++;
+
+		std::vector<pair_type>& bucket = m_buckets[index];
+
+		m_last = bucket.front().first;
+		for (const pair_type& pair : bucket)
+		{
+			if (pair.first < m_last)
+				m_last = pair.first;
+		}
+
+		for (pair_type& pair : bucket)
+		{
+			const size_t target = GetBucket(pair.first);
+
+			m_buckets[target].push_back(std::move(pair));
+			m_mask |= static_cast<uint64_t>(1) << target;
+		}
+
+		bucket.clear();
+		m_mask &= ~(static_cast<uint64_t>(1) << index);
+	}
+
+	template <typename ObjType>
+	size_t RadixHeap<ObjType>::GetBucket(uint32_t bits) const
+	{
+		const uint32_t diff = bits ^ m_last;
+
+#if defined(__GNUC__) || defined(__clang__)
+		return diff != 0 ? 32 - __builtin_clz(diff) : 0;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		return _BitScanReverse(&index, diff) ? index + 1 : 0;
+#else
+		uint32_t rest = diff;
+		size_t width = 0;
+
+		for (uint32_t shift = 16; shift > 0; shift >>= 1)
+		{
+			if (rest >> shift)
+			{
+				rest >>= shift;
+				width += shift;
+			}
+		}
+
+		return width + rest;
+#endif
+	}
+
+	template <typename ObjType>
+	uint32_t RadixHeap<ObjType>::ToBits(float key)
+	{
+		uint32_t bits;
+		memcpy(&bits, &key, sizeof(bits));
+		return bits;
+	}
+
+	template <typename ObjType>
+	float RadixHeap<ObjType>::ToKey(uint32_t bits)
+	{
+		float key;
+		memcpy(&key, &bits, sizeof(key));
+		return key;
+	}
+
+	template <typename ObjType>
+	void RadixHeap<ObjType>::Clear()
+	{
+		for (size_t i = 0; m_mask != 0; i++, m_mask >>= 1)
+		{
+			if (m_mask & 1)
+				m_buckets[i].clear();
+		}
+
+		m_last = 0;
+		m_size = 0;
+	}
+
+	template <typename ObjType>
+	void RadixHeap<ObjType>::Reset()
+	{
+		for (std::vector<pair_type>& bucket : m_buckets)
+			std::vector<pair_type>().swap(bucket);
+
+		m_mask = 0;
+		m_last = 0;
+		m_size = 0;
+	}
+
+	template <typename ObjType>
+	void RadixHeap<ObjType>::Pop()
+	{
+		if (m_size == 0)
+			return;
+
+		m_buckets[0].pop_back();
+		if (!m_buckets[0].empty())
+		{
+			m_size--;
+			return;
+		}
+
+		m_mask &= ~static_cast<uint64_t>(1);
+		if (--m_size > 0)
+			Refill();
+	}
+
+	template <typename ObjType>
+	void RadixHeap<ObjType>::Push(float key, const ObjType& object)
+	{
+		uint32_t bits = ToBits(key);
+
+		if (m_size == 0)
+			m_last = bits;
+		else if (bits < m_last)
+			bits = m_last;
+
+		const size_t index = GetBucket(bits);
+
+		m_buckets[index].emplace_back(bits, object);
+		m_mask |= static_cast<uint64_t>(1) << index;
+		m_size++;
+	}
+}
\ No newline at end of file
@@ -17,6 +17,7 @@ namespace dg::impl
 		Random(const uint64_t seed) { Seed(seed); }
 
 		void Seed(uint64_t seed = 0);
+		void Seed(uint64_t seed, uint64_t stream);
 
 		bool GetBit();
 		float GetFP32();
@@ -40,6 +41,16 @@ namespace dg::impl
 		}
 	}
 
+	inline void Random::Seed(uint64_t seed, uint64_t stream)
+	{
+		// Stream identifier is scrambled with the SplitMix64 finalizer,
+		// so that nearby identifiers produce unrelated states.
+
+		stream = (stream ^ (stream >> 30)) * 0xbf58476d1ce4e5b9;
+		stream = (stream ^ (stream >> 27)) * 0x94d049bb133111eb;
+		Seed(seed ^ stream ^ (stream >> 31));
+	}
+
 	inline bool Random::GetBit()
 	{
 		const auto [a, b] = Get32P();
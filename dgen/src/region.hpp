@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include "../include/dgen/dgen.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace dg::impl
+{
+	struct Region
+	{
+		// Elements are tested by their bounding boxes. A path covers the cells of both of its ends.
+
+		Rect m_rect;
+
+		bool Intersects(int x, int y, int w, int h) const
+		{
+			return x < m_rect.x + m_rect.w && m_rect.x < x + w && y < m_rect.y + m_rect.h && m_rect.y < y + h;
+		}
+
+		bool Intersects(const Rect& rect) const { return Intersects(rect.x, rect.y, rect.w, rect.h); }
+		bool Intersects(const Point& point) const { return Intersects(point.x, point.y, 1, 1); }
+
+		bool Intersects(const std::pair<Point, Vec>& path) const
+		{
+			const auto& [point, shift] = path;
+			const int x = std::min(point.x, point.x + shift.x);
+			const int y = std::min(point.y, point.y + shift.y);
+
+			return Intersects(x, y, std::abs(shift.x) + 1, std::abs(shift.y) + 1);
+		}
+
+		void Slice(const Output& source, Vec shift, Output& target) const;
+	};
+
+	inline void Region::Slice(const Output& source, Vec shift, Output& target) const
+	{
+		// Elements keep their order, and they are moved by the shift only after they are tested.
+
+		for (Rect rect : source.m_rooms)
+		{
+			if (!Intersects(rect))
+				continue;
+
+			rect.x += shift.x;
+			rect.y += shift.y;
+			target.m_rooms.push_back(rect);
+		}
+
+		for (Point point : source.m_entrances)
+		{
+			if (!Intersects(point))
+				continue;
+
+			point.x += shift.x;
+			point.y += shift.y;
+			target.m_entrances.push_back(point);
+		}
+
+		for (std::pair<Point, Vec> path : source.m_paths)
+		{
+			if (!Intersects(path))
+				continue;
+
+			path.first.x += shift.x;
+			path.first.y += shift.y;
+			target.m_paths.push_back(path);
+		}
+	}
+}
\ No newline at end of file
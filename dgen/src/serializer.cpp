@@ -0,0 +1,255 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#include "serializer.hpp"
+
+namespace dg::impl
+{
+	static constexpr std::array<uint32_t, 256> MakeChecksumTable()
+	{
+		std::array<uint32_t, 256> table{};
+		for (uint32_t index = 0; index < table.size(); index++)
+		{
+			uint32_t value = index;
+			for (int i = 0; i < 8; i++)
+				value = (value >> 1) ^ (0xEDB88320 & (0 - (value & 1)));
+
+			table[index] = value;
+		}
+
+		return table;
+	}
+
+	const std::array<uint32_t, 256> Checksum::s_table = MakeChecksumTable();
+
+	Layout::Header Layout::MakeHeader(const Input& input, const Output& output)
+	{
+		Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.m_magic, s_magic, sizeof(s_magic));
+
+		header.m_version = s_version;
+		header.m_byteOrder = s_byteOrder;
+		header.m_headerSize = sizeof(Header);
+
+		header.m_rooms = { Align(sizeof(Header)), output.m_rooms.size(), sizeof(Rect) };
+		header.m_entrances = { Align(header.m_rooms.m_offset + output.m_rooms.size() * sizeof(Rect)), output.m_entrances.size(), sizeof(Point) };
+		header.m_paths = { Align(header.m_entrances.m_offset + output.m_entrances.size() * sizeof(Point)), output.m_paths.size(), sizeof(output.m_paths[0]) };
+
+		Parameters& params = header.m_input;
+		params.m_seed = input.m_seed;
+		params.m_width = input.m_width;
+		params.m_height = input.m_height;
+		params.m_minDepth = input.m_minDepth;
+		params.m_maxDepth = input.m_maxDepth;
+		params.m_spaceInterdistance = input.m_spaceInterdistance;
+		params.m_spaceSizeRandomness = input.m_spaceSizeRandomness;
+		params.m_sparseAreaDepth = input.m_sparseAreaDepth;
+		params.m_sparseAreaDens = input.m_sparseAreaDens;
+		params.m_sparseAreaProb = input.m_sparseAreaProb;
+		params.m_minRoomSize = input.m_minRoomSize;
+		params.m_maxRoomSize = input.m_maxRoomSize;
+		params.m_doubleRoomProb = input.m_doubleRoomProb;
+		params.m_heuristicFactor = input.m_heuristicFactor;
+		params.m_pathCostFactor = input.m_pathCostFactor;
+		params.m_extraPathCount = input.m_extraPathCount;
+		params.m_extraPathDepth = input.m_extraPathDepth;
+		params.m_generateFewerPaths = input.m_generateFewerPaths;
+		params.m_parallelDepth = input.m_parallelDepth;
+
+		return header;
+	}
+
+	Input Layout::ReadParameters(const Parameters& params)
+	{
+		Input input{};
+
+		input.m_seed = params.m_seed;
+		input.m_width = params.m_width;
+		input.m_height = params.m_height;
+		input.m_minDepth = params.m_minDepth;
+		input.m_maxDepth = params.m_maxDepth;
+		input.m_spaceInterdistance = params.m_spaceInterdistance;
+		input.m_spaceSizeRandomness = params.m_spaceSizeRandomness;
+		input.m_sparseAreaDepth = params.m_sparseAreaDepth;
+		input.m_sparseAreaDens = params.m_sparseAreaDens;
+		input.m_sparseAreaProb = params.m_sparseAreaProb;
+		input.m_minRoomSize = params.m_minRoomSize;
+		input.m_maxRoomSize = params.m_maxRoomSize;
+		input.m_doubleRoomProb = params.m_doubleRoomProb;
+		input.m_heuristicFactor = params.m_heuristicFactor;
+		input.m_pathCostFactor = params.m_pathCostFactor;
+		input.m_extraPathCount = params.m_extraPathCount;
+		input.m_extraPathDepth = params.m_extraPathDepth;
+		input.m_generateFewerPaths = params.m_generateFewerPaths != 0;
+		input.m_parallelDepth = params.m_parallelDepth;
+		input.m_threadCount = 0;
+
+		return input;
+	}
+
+	void Layout::CheckSection(const Section& section, size_t elementSize, size_t elementAlign, size_t dataSize)
+	{
+		if (section.m_elementSize != elementSize)
+			throw std::runtime_error("Dungeon layout was written on an incompatible platform");
+
+		if (section.m_offset < sizeof(Header) || section.m_offset % elementAlign != 0)
+			throw std::runtime_error("Dungeon layout was corrupted");
+
+		if (section.m_offset > dataSize || section.m_count > (dataSize - section.m_offset) / elementSize)
+			throw std::runtime_error("Dungeon layout was truncated");
+	}
+}
+
+namespace dg
+{
+	void SaveOutput(const Output* output, std::vector<std::uint8_t>* buffer)
+	{
+		if (output == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output object was null");
+
+		if (buffer == nullptr)
+			throw std::runtime_error("Pointer to the buffer was null");
+
+		impl::VectorSink sink(*buffer);
+		impl::Encoder<impl::VectorSink>(sink).Encode(*output);
+	}
+
+	void SaveOutput(const Output* output, std::ostream& stream)
+	{
+		if (output == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output object was null");
+
+		impl::StreamSink sink(stream);
+		impl::Encoder<impl::StreamSink>(sink).Encode(*output);
+	}
+
+	std::size_t LoadOutput(const std::uint8_t* data, std::size_t size, Output* output)
+	{
+		if (output == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output object was null");
+
+		if (data == nullptr && size > 0)
+			throw std::runtime_error("Pointer to the data was null");
+
+		impl::MemorySource source(data, size);
+		impl::Decoder<impl::MemorySource>(source).Decode(*output);
+
+		return static_cast<std::size_t>(source.Position() - data);
+	}
+
+	void LoadOutput(std::istream& stream, Output* output)
+	{
+		if (output == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output object was null");
+
+		impl::StreamSource source(stream);
+		impl::Decoder<impl::StreamSource>(source).Decode(*output);
+	}
+
+	std::size_t GetOutputLayoutSize(const Output* output)
+	{
+		if (output == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output object was null");
+
+		const impl::Layout::Header header = impl::Layout::MakeHeader(Input{}, *output);
+		return static_cast<std::size_t>(header.m_paths.m_offset + header.m_paths.m_count * header.m_paths.m_elementSize);
+	}
+
+	void SaveOutputLayout(const Input* input, const Output* output, std::vector<std::uint8_t>* buffer)
+	{
+		if (input == nullptr)
+			throw std::runtime_error("Pointer to the dg::Input object was null");
+
+		if (buffer == nullptr)
+			throw std::runtime_error("Pointer to the buffer was null");
+
+		const std::size_t size = GetOutputLayoutSize(output);
+		const impl::Layout::Header header = impl::Layout::MakeHeader(*input, *output);
+
+		buffer->assign(size, 0);
+		std::uint8_t* const data = buffer->data();
+
+		const auto Copy = [data](std::size_t begin, const void* src, std::size_t size) -> void
+		{
+			if (size > 0)
+				memcpy(data + begin, src, size);
+		};
+
+		Copy(0, &header, sizeof(header));
+		Copy(header.m_rooms.m_offset, output->m_rooms.data(), output->m_rooms.size() * sizeof(Rect));
+		Copy(header.m_entrances.m_offset, output->m_entrances.data(), output->m_entrances.size() * sizeof(Point));
+		Copy(header.m_paths.m_offset, output->m_paths.data(), output->m_paths.size() * sizeof(output->m_paths[0]));
+	}
+
+	void SaveOutputLayout(const Input* input, const Output* output, std::ostream& stream)
+	{
+		if (input == nullptr)
+			throw std::runtime_error("Pointer to the dg::Input object was null");
+
+		const std::size_t size = GetOutputLayoutSize(output);
+		const impl::Layout::Header header = impl::Layout::MakeHeader(*input, *output);
+
+		static constexpr char s_padding[impl::Layout::s_alignment]{};
+		std::size_t offset = 0;
+
+		const auto Write = [&stream, &offset](std::size_t begin, const void* data, std::size_t size) -> void
+		{
+			stream.write(s_padding, static_cast<std::streamsize>(begin - offset));
+			stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			offset = begin + size;
+		};
+
+		Write(0, &header, sizeof(header));
+		Write(header.m_rooms.m_offset, output->m_rooms.data(), output->m_rooms.size() * sizeof(Rect));
+		Write(header.m_entrances.m_offset, output->m_entrances.data(), output->m_entrances.size() * sizeof(Point));
+		Write(header.m_paths.m_offset, output->m_paths.data(), output->m_paths.size() * sizeof(output->m_paths[0]));
+
+		if (offset != size || !stream.good())
+			throw std::runtime_error("Failed to write the dungeon to the stream");
+	}
+
+	OutputView ViewOutput(const void* data, std::size_t size)
+	{
+		using impl::Layout;
+
+		if (data == nullptr)
+			throw std::runtime_error("Pointer to the data was null");
+
+		if (size < sizeof(Layout::Header))
+			throw std::runtime_error("Dungeon layout was truncated");
+
+		Layout::Header header;
+		memcpy(&header, data, sizeof(header));
+
+		if (memcmp(header.m_magic, Layout::s_magic, sizeof(Layout::s_magic)) != 0)
+			throw std::runtime_error("Data doesn't describe a dungeon layout");
+
+		if (header.m_version != Layout::s_version)
+			throw std::runtime_error("Unsupported version of the dungeon layout");
+
+		if (header.m_byteOrder != Layout::s_byteOrder || header.m_headerSize != sizeof(Layout::Header))
+			throw std::runtime_error("Dungeon layout was written on an incompatible platform");
+
+		using path_type = std::pair<Point, Vec>;
+		if (reinterpret_cast<std::uintptr_t>(data) % alignof(path_type) != 0)
+			throw std::runtime_error("Dungeon layout was misaligned");
+
+		Layout::CheckSection(header.m_rooms, sizeof(Rect), alignof(Rect), size);
+		Layout::CheckSection(header.m_entrances, sizeof(Point), alignof(Point), size);
+		Layout::CheckSection(header.m_paths, sizeof(path_type), alignof(path_type), size);
+
+		const std::uint8_t* const bytes = static_cast<const std::uint8_t*>(data);
+		OutputView view;
+
+		view.m_input = Layout::ReadParameters(header.m_input);
+		view.m_rooms = reinterpret_cast<const Rect*>(bytes + header.m_rooms.m_offset);
+		view.m_roomCount = static_cast<std::size_t>(header.m_rooms.m_count);
+		view.m_entrances = reinterpret_cast<const Point*>(bytes + header.m_entrances.m_offset);
+		view.m_entranceCount = static_cast<std::size_t>(header.m_entrances.m_count);
+		view.m_paths = reinterpret_cast<const path_type*>(bytes + header.m_paths.m_offset);
+		view.m_pathCount = static_cast<std::size_t>(header.m_paths.m_count);
+
+		return view;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,440 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include "../include/dgen/dgen.hpp"
+
+#include <array>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace dg::impl
+{
+	struct Format
+	{
+		// Header is made of the magic bytes, the version and the counts of rooms, entrances and paths.
+		// Every coordinate is stored as a zigzag varint of its difference from the same coordinate of the previous
+		// element, while sizes and path shifts are stored as they are. A path shift has at most one non-zero
+		// component, so its axis is kept in the low bits of the value of the other one. Dungeon ends with
+		// the little-endian CRC-32 of all bytes before it, so corrupted data is rejected rather than decoded.
+
+		static constexpr uint8_t s_magic[4] = { 'D', 'G', 'E', 'N' };
+		static constexpr uint8_t s_version = 2;
+
+		enum Shift : int { HORIZONTAL, VERTICAL, DIAGONAL };
+		static constexpr int s_shiftBits = 2;
+
+		static constexpr size_t s_bufferSize = 1 << 12;
+		static constexpr size_t s_streamReserve = 1 << 16;
+		static constexpr int s_checksumSize = 4;
+	};
+
+	class Checksum
+	{
+		// CRC-32 with the reflected polynomial 0xEDB88320, the same as in zlib.
+
+		static const std::array<uint32_t, 256> s_table;
+		uint32_t m_value = 0xFFFFFFFF;
+
+	public:
+		void Update(uint8_t byte) { m_value = s_table[(m_value ^ byte) & 0xFF] ^ (m_value >> 8); }
+		uint32_t Get() const { return ~m_value; }
+	};
+
+	struct Layout
+	{
+		// Mappable layout is the header followed by rooms, entrances and paths, stored exactly as they are in memory.
+		// Every section begins at a multiple of s_alignment, so the arrays can be used in place. Element sizes and
+		// the byte order are kept in the header to reject data written on an incompatible platform.
+
+		static constexpr uint8_t s_magic[4] = { 'D', 'G', 'M', 'L' };
+		static constexpr uint32_t s_version = 1;
+		static constexpr uint32_t s_byteOrder = 0x01020304;
+		static constexpr size_t s_alignment = 64;
+
+		struct Section
+		{
+			uint64_t m_offset;
+			uint64_t m_count;
+			uint64_t m_elementSize;
+		};
+
+		struct Parameters
+		{
+			uint64_t m_seed;
+			int32_t m_width;
+			int32_t m_height;
+			int32_t m_minDepth;
+			int32_t m_maxDepth;
+			int32_t m_spaceInterdistance;
+			float m_spaceSizeRandomness;
+			int32_t m_sparseAreaDepth;
+			float m_sparseAreaDens;
+			float m_sparseAreaProb;
+			float m_minRoomSize;
+			float m_maxRoomSize;
+			float m_doubleRoomProb;
+			float m_heuristicFactor;
+			float m_pathCostFactor;
+			int32_t m_extraPathCount;
+			int32_t m_extraPathDepth;
+			int32_t m_generateFewerPaths;
+			int32_t m_parallelDepth;
+		};
+
+		struct Header
+		{
+			uint8_t m_magic[4];
+			uint32_t m_version;
+			uint32_t m_byteOrder;
+			uint32_t m_headerSize;
+
+			Section m_rooms;
+			Section m_entrances;
+			Section m_paths;
+			Parameters m_input;
+		};
+
+		static size_t Align(size_t offset) { return (offset + s_alignment - 1) & ~(s_alignment - 1); }
+
+		static Header MakeHeader(const Input& input, const Output& output);
+		static Input ReadParameters(const Parameters& params);
+		static void CheckSection(const Section& section, size_t elementSize, size_t elementAlign, size_t dataSize);
+	};
+
+	class VectorSink
+	{
+		std::vector<uint8_t>& m_buffer;
+
+	public:
+		VectorSink(std::vector<uint8_t>& buffer) : m_buffer(buffer) {}
+
+		void Put(uint8_t byte) { m_buffer.push_back(byte); }
+		void Flush() {}
+	};
+
+	class StreamSink
+	{
+		std::ostream& m_stream;
+		uint8_t m_buffer[Format::s_bufferSize];
+		size_t m_size = 0;
+
+	public:
+		StreamSink(std::ostream& stream) : m_stream(stream) {}
+
+		void Put(uint8_t byte)
+		{
+			if (m_size == Format::s_bufferSize)
+				Flush();
+
+			m_buffer[m_size++] = byte;
+		}
+
+		void Flush()
+		{
+			m_stream.write(reinterpret_cast<const char*>(m_buffer), static_cast<std::streamsize>(m_size));
+			m_size = 0;
+
+			if (!m_stream.good())
+				throw std::runtime_error("Failed to write the dungeon to the stream");
+		}
+	};
+
+	class MemorySource
+	{
+		const uint8_t* m_crr;
+		const uint8_t* const m_end;
+
+	public:
+		MemorySource(const uint8_t* data, size_t size) : m_crr(data), m_end(data + size) {}
+
+		uint8_t Get()
+		{
+			if (m_crr == m_end)
+				throw std::runtime_error("Dungeon data was truncated");
+
+			return *(m_crr++);
+		}
+
+		size_t Available() const { return static_cast<size_t>(m_end - m_crr); }
+		const uint8_t* Position() const { return m_crr; }
+	};
+
+	class StreamSource
+	{
+		// Bytes are taken straight from the stream buffer, so the stream is left right after the dungeon.
+
+		std::streambuf* const m_buffer;
+
+	public:
+		StreamSource(std::istream& stream) : m_buffer(stream.rdbuf()) {}
+
+		uint8_t Get()
+		{
+			const std::streambuf::int_type byte = m_buffer->sbumpc();
+			if (std::streambuf::traits_type::eq_int_type(byte, std::streambuf::traits_type::eof()))
+				throw std::runtime_error("Dungeon data was truncated");
+
+			return static_cast<uint8_t>(std::streambuf::traits_type::to_char_type(byte));
+		}
+
+		size_t Available() const { return Format::s_streamReserve; }
+	};
+
+	template <typename Sink>
+	class Encoder
+	{
+		Sink& m_sink;
+		Checksum m_checksum;
+
+		void Put(uint8_t byte)
+		{
+			m_checksum.Update(byte);
+			m_sink.Put(byte);
+		}
+
+	public:
+		Encoder(Sink& sink) : m_sink(sink) {}
+
+		void Unsigned(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				Put(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+
+			Put(static_cast<uint8_t>(value));
+		}
+
+		void Signed(int64_t value)
+		{
+			Unsigned((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+		}
+
+		void Delta(int value, int& prev)
+		{
+			Signed(static_cast<int64_t>(value) - prev);
+			prev = value;
+		}
+
+		void Encode(const Output& output);
+	};
+
+	template <typename Source>
+	class Decoder
+	{
+		Source& m_source;
+		Checksum m_checksum;
+
+		uint8_t Get()
+		{
+			const uint8_t byte = m_source.Get();
+			m_checksum.Update(byte);
+
+			return byte;
+		}
+
+	public:
+		Decoder(Source& source) : m_source(source) {}
+
+		uint64_t Unsigned()
+		{
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				const uint8_t byte = Get();
+
+				// Only the lowest bit of the tenth byte fits in 64 bits.
+				if (shift == 63 && byte > 1)
+					throw std::runtime_error("Dungeon data was corrupted");
+
+				value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+				if ((byte & 0x80) == 0)
+					return value;
+			}
+
+			throw std::runtime_error("Dungeon data was corrupted");
+		}
+
+		int64_t Signed()
+		{
+			const uint64_t value = Unsigned();
+			return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+		}
+
+		int Int(int64_t value)
+		{
+			if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max())
+				throw std::runtime_error("Dungeon data was corrupted");
+
+			return static_cast<int>(value);
+		}
+
+		int Delta(int& prev)
+		{
+			// Range is checked before adding, since the sum of corrupted values could overflow.
+			const int64_t value = Signed();
+			if (value > static_cast<int64_t>(std::numeric_limits<int>::max()) - prev || value < static_cast<int64_t>(std::numeric_limits<int>::min()) - prev)
+				throw std::runtime_error("Dungeon data was corrupted");
+
+			return prev = static_cast<int>(prev + value);
+		}
+
+		size_t Count()
+		{
+			const uint64_t count = Unsigned();
+			if (count > std::numeric_limits<size_t>::max())
+				throw std::runtime_error("Dungeon data was corrupted");
+
+			return static_cast<size_t>(count);
+		}
+
+		template <typename Type>
+		void Prepare(std::vector<Type>& vec, size_t count)
+		{
+			// Counts come from the data, so memory for elements is reserved only when they might fit in the source.
+			vec.clear();
+			vec.reserve(count < m_source.Available() ? count : m_source.Available());
+		}
+
+		void Decode(Output& output);
+	};
+
+	template <typename Sink>
+	void Encoder<Sink>::Encode(const Output& output)
+	{
+		for (const uint8_t byte : Format::s_magic)
+			Put(byte);
+
+		Put(Format::s_version);
+
+		Unsigned(output.m_rooms.size());
+		Unsigned(output.m_entrances.size());
+		Unsigned(output.m_paths.size());
+
+		Point prev(0, 0);
+		for (const Rect& room : output.m_rooms)
+		{
+			Delta(room.x, prev.x);
+			Delta(room.y, prev.y);
+			Signed(room.w);
+			Signed(room.h);
+		}
+
+		prev = Point(0, 0);
+		for (const Point& entrance : output.m_entrances)
+		{
+			Delta(entrance.x, prev.x);
+			Delta(entrance.y, prev.y);
+		}
+
+		const auto Pack = [](int64_t value, Format::Shift axis) -> int64_t { return value * (1 << Format::s_shiftBits) + axis; };
+
+		prev = Point(0, 0);
+		for (const auto& [point, shift] : output.m_paths)
+		{
+			Delta(point.x, prev.x);
+			Delta(point.y, prev.y);
+
+			if (shift.y == 0)
+				Signed(Pack(shift.x, Format::Shift::HORIZONTAL));
+			else if (shift.x == 0)
+				Signed(Pack(shift.y, Format::Shift::VERTICAL));
+			else
+			{
+				Signed(Pack(shift.x, Format::Shift::DIAGONAL));
+				Signed(shift.y);
+			}
+		}
+
+		const uint32_t checksum = m_checksum.Get();
+		for (int i = 0; i < Format::s_checksumSize; i++)
+			m_sink.Put(static_cast<uint8_t>(checksum >> (i * 8)));
+
+		m_sink.Flush();
+	}
+
+	template <typename Source>
+	void Decoder<Source>::Decode(Output& output)
+	{
+		for (const uint8_t byte : Format::s_magic)
+		{
+			if (Get() != byte)
+				throw std::runtime_error("Data doesn't describe a dungeon");
+		}
+
+		if (Get() != Format::s_version)
+			throw std::runtime_error("Unsupported version of the dungeon format");
+
+		const size_t roomCount = Count();
+		const size_t entranceCount = Count();
+		const size_t pathCount = Count();
+
+		Prepare(output.m_rooms, roomCount);
+		Prepare(output.m_entrances, entranceCount);
+		Prepare(output.m_paths, pathCount);
+
+		Point prev(0, 0);
+		for (size_t i = 0; i < roomCount; i++)
+		{
+			Rect& room = output.m_rooms.emplace_back();
+			room.x = Delta(prev.x);
+			room.y = Delta(prev.y);
+			room.w = Int(Signed());
+			room.h = Int(Signed());
+		}
+
+		prev = Point(0, 0);
+		for (size_t i = 0; i < entranceCount; i++)
+		{
+			Point& entrance = output.m_entrances.emplace_back();
+			entrance.x = Delta(prev.x);
+			entrance.y = Delta(prev.y);
+		}
+
+		prev = Point(0, 0);
+		for (size_t i = 0; i < pathCount; i++)
+		{
+			auto& [point, shift] = output.m_paths.emplace_back();
+			point.x = Delta(prev.x);
+			point.y = Delta(prev.y);
+
+			// Arithmetic shift keeps the sign of the value, while its low bits always hold the axis.
+			const int64_t packed = Signed();
+			const int64_t value = packed >> Format::s_shiftBits;
+
+			switch (static_cast<int>(packed & ((1 << Format::s_shiftBits) - 1)))
+			{
+			case Format::Shift::HORIZONTAL:
+				shift = Vec(Int(value), 0);
+				break;
+
+			case Format::Shift::VERTICAL:
+				shift = Vec(0, Int(value));
+				break;
+
+			case Format::Shift::DIAGONAL:
+				shift = Vec(Int(value), Int(Signed()));
+				break;
+
+			default:
+				throw std::runtime_error("Dungeon data was corrupted");
+			}
+		}
+
+		uint32_t checksum = 0;
+		for (int i = 0; i < Format::s_checksumSize; i++)
+			checksum |= static_cast<uint32_t>(m_source.Get()) << (i * 8);
+
+		if (checksum != m_checksum.Get())
+			throw std::runtime_error("Dungeon data was corrupted");
+	}
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <stddef.h>
+
+namespace dg::impl
+{
+	class ThreadPool
+	{
+		using task_type = std::function<void(size_t, size_t)>;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wakeCondition;
+		std::condition_variable m_doneCondition;
+		std::vector<std::thread> m_threads;
+
+		const task_type* m_task = nullptr;
+		size_t m_taskCount = 0;
+		std::atomic<size_t> m_nextTask = 0;
+		std::exception_ptr m_exception;
+
+		size_t m_generation = 0;
+		size_t m_participants = 0;
+		size_t m_active = 0;
+		bool m_stop = false;
+
+		void Work(size_t id);
+		void Process(size_t id);
+
+	public:
+		ThreadPool() = default;
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool& ref) = delete;
+		ThreadPool& operator=(const ThreadPool& ref) = delete;
+
+		ThreadPool(ThreadPool&& ref) noexcept = delete;
+		ThreadPool& operator=(ThreadPool&& ref) noexcept = delete;
+
+		void Run(size_t taskCount, size_t threadCount, const task_type& task);
+		void Reset();
+
+		static size_t GetThreadCount(int requested);
+	};
+
+	inline ThreadPool::~ThreadPool() { Reset(); }
+
+	inline void ThreadPool::Work(size_t id)
+	{
+		size_t seen = 0;
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (true)
+		{
+			m_wakeCondition.wait(lock, [this, id, &seen]() { return m_stop || (m_generation != seen && id < m_participants); });
+			if (m_stop) return;
+
+			seen = m_generation;
+			lock.unlock();
+
+			Process(id);
+
+			lock.lock();
+			if (--m_active == 0)
+				m_doneCondition.notify_one();
+		}
+	}
+
+	inline void ThreadPool::Process(size_t id)
+	{
+		for (size_t i = m_nextTask++; i < m_taskCount; i = m_nextTask++)
+		{
+			try { (*m_task)(i, id); }
+			catch (...)
+			{
+				const std::lock_guard<std::mutex> lock(m_mutex);
+				if (!m_exception) m_exception = std::current_exception();
+			}
+		}
+	}
+
+	inline void ThreadPool::Run(size_t taskCount, size_t threadCount, const task_type& task)
+	{
+		// Task receives its own index and the index of the executing thread, which is always lower than threadCount.
+
+		if (threadCount > taskCount)
+			threadCount = taskCount;
+
+		if (threadCount < 2)
+		{
+			for (size_t i = 0; i < taskCount; i++)
+				task(i, 0);
+
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (m_threads.size() < threadCount - 1)
+			m_threads.emplace_back(&ThreadPool::Work, this, m_threads.size());
+
+		m_task = &task;
+		m_taskCount = taskCount;
+		m_nextTask = 0;
+		m_exception = nullptr;
+
+		m_generation++;
+		m_participants = threadCount - 1;
+		m_active = m_participants;
+
+		lock.unlock();
+		m_wakeCondition.notify_all();
+
+		Process(m_participants);
+
+		lock.lock();
+		m_doneCondition.wait(lock, [this]() { return m_active == 0; });
+
+		m_task = nullptr;
+		m_participants = 0;
+
+		if (m_exception)
+			std::rethrow_exception(std::exchange(m_exception, nullptr));
+	}
+
+	inline void ThreadPool::Reset()
+	{
+		{
+			const std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_wakeCondition.notify_all();
+		for (std::thread& thread : m_threads)
+			thread.join();
+
+		m_threads.clear();
+		m_stop = false;
+	}
+
+	inline size_t ThreadPool::GetThreadCount(int requested)
+	{
+		if (requested > 0)
+			return static_cast<size_t>(requested);
+
+		const unsigned int available = std::thread::hardware_concurrency();
+		return available > 0 ? available : 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,332 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#include "world.hpp"
+#include "region.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+
+namespace dg::impl
+{
+	size_t World::ChunkHash::operator()(const std::pair<int64_t, int64_t>& key) const
+	{
+		return static_cast<size_t>(Mix(0, key.first, key.second, 0));
+	}
+
+	World::World(const Input& input, size_t capacity) : m_input(input), m_capacity(std::max<size_t>(capacity, 1)), m_chunkInput(input) {}
+
+	const Output& World::GetChunk(int64_t x, int64_t y)
+	{
+		const auto iter = m_index.find(std::make_pair(x, y));
+		if (iter != m_index.end())
+		{
+			m_chunks.splice(m_chunks.begin(), m_chunks, iter->second);
+			return iter->second->m_output;
+		}
+
+		if (m_chunks.size() < m_capacity)
+			m_chunks.emplace_front();
+		else
+		{
+			m_index.erase(std::make_pair(m_chunks.back().m_x, m_chunks.back().m_y));
+			m_chunks.splice(m_chunks.begin(), m_chunks, std::prev(m_chunks.end()));
+		}
+
+		// Entry is registered only after the chunk is generated, so a failed generation leaves no invalid entry.
+		Chunk& chunk = m_chunks.front();
+
+		try { GenerateChunk(x, y, chunk.m_output); }
+		catch (...)
+		{
+			m_chunks.pop_front();
+			throw;
+		}
+
+		chunk.m_x = x;
+		chunk.m_y = y;
+		m_index[std::make_pair(x, y)] = m_chunks.begin();
+
+		return chunk.m_output;
+	}
+
+	void World::GenerateChunk(int64_t x, int64_t y, Output& output)
+	{
+		m_chunkInput.m_seed = Mix(m_input.m_seed, x, y, 0);
+		m_generator.Generate(&m_chunkInput, &output);
+
+		const int w = GetWidth();
+		const int h = GetHeight();
+
+		// Gates are kept away from the corners of the chunk. Neighbours are found with wrapping arithmetic,
+		// so even the chunks at the limits of the coordinate range agree on their common gates.
+
+		const auto Gate = [this](uint64_t xEdge, uint64_t yEdge, Edge edge, int length) -> int
+		{
+			const uint64_t hash = Mix(m_input.m_seed, static_cast<int64_t>(xEdge), static_cast<int64_t>(yEdge), edge);
+			return 1 + static_cast<int>(hash % static_cast<uint64_t>(length - 1));
+		};
+
+		const uint64_t xChunk = static_cast<uint64_t>(x);
+		const uint64_t yChunk = static_cast<uint64_t>(y);
+
+		int gates[4];
+		gates[Dir::NORTH] = Gate(xChunk, yChunk - 1, Edge::HORIZONTAL, w);
+		gates[Dir::EAST] = Gate(xChunk, yChunk, Edge::VERTICAL, h);
+		gates[Dir::SOUTH] = Gate(xChunk, yChunk, Edge::HORIZONTAL, w);
+		gates[Dir::WEST] = Gate(xChunk - 1, yChunk, Edge::VERTICAL, h);
+
+		ConnectGates(gates);
+
+		output.m_paths.emplace_back(Point(w, gates[Dir::EAST]), Vec(1, 0));
+		output.m_paths.emplace_back(Point(gates[Dir::SOUTH], h), Vec(0, 1));
+	}
+
+	void World::GenerateRegion(int64_t x, int64_t y, int w, int h, Output& output)
+	{
+		output.m_rooms.clear();
+		output.m_entrances.clear();
+		output.m_paths.clear();
+
+		if (w <= 0 || h <= 0)
+			return;
+
+		// Steps over the western and northern edges of a chunk belong to its neighbours, so these are visited
+		// too when the region begins right at the edge.
+
+		const int64_t wChunk = m_input.m_width;
+		const int64_t hChunk = m_input.m_height;
+
+		const int64_t xBegin = GetChunkIndex(x - 1, wChunk);
+		const int64_t yBegin = GetChunkIndex(y - 1, hChunk);
+		const int64_t xEnd = GetChunkIndex(x + w - 1, wChunk);
+		const int64_t yEnd = GetChunkIndex(y + h - 1, hChunk);
+
+		for (int64_t yCrr = yBegin; yCrr <= yEnd; yCrr++)
+		{
+			for (int64_t xCrr = xBegin; xCrr <= xEnd; xCrr++)
+			{
+				const int xShift = static_cast<int>(xCrr * wChunk - x);
+				const int yShift = static_cast<int>(yCrr * hChunk - y);
+
+				const Region region{ Rect(-xShift, -yShift, w, h) };
+				region.Slice(GetChunk(xCrr, yCrr), Vec(xShift, yShift), output);
+			}
+		}
+	}
+
+	void World::ConnectGates(const int gates[4])
+	{
+		// Positions on the border are described by offsets along it, starting from the origin and going clockwise.
+
+		const Generator& generator = m_generator;
+		Output& output = *generator.m_output;
+
+		const int w = GetWidth();
+		const int h = GetHeight();
+		const int perimeter = GetPerimeter();
+
+		const int d0 = generator.m_spaceOffset;
+		const int d1 = generator.m_spaceOffset - 1;
+
+		struct Exit
+		{
+			int m_offset;
+			uint32_t m_room;
+			Dir m_dir;
+		};
+
+		std::vector<Exit> exits;
+		for (size_t i = 0; i < generator.m_rooms.size(); i++)
+		{
+			const Room& room = generator.m_rooms[i];
+			const Point* const ent = room.m_entrances;
+			const auto& [xS, yS, wS, hS] = generator.m_tree[room.m_node].m_space;
+			const uint32_t vertex = Graph::FromRoom(i);
+
+			if (yS - d0 == 0)
+				exits.push_back({ ent[Dir::NORTH].x, vertex, Dir::NORTH });
+
+			if (xS + wS + d1 == w)
+				exits.push_back({ w + ent[Dir::EAST].y, vertex, Dir::EAST });
+
+			if (yS + hS + d1 == h)
+				exits.push_back({ w + h + w - ent[Dir::SOUTH].x, vertex, Dir::SOUTH });
+
+			if (xS - d0 == 0)
+				exits.push_back({ w + h + w + h - ent[Dir::WEST].y, vertex, Dir::WEST });
+		}
+
+		const int offsets[4] = { gates[Dir::NORTH], w + gates[Dir::EAST], w + h + w - gates[Dir::SOUTH], w + h + w + h - gates[Dir::WEST] };
+
+		if (exits.empty())
+		{
+			// Without any room at the border, gates are at least connected with each other, so the world stays connected.
+			for (int i = 1; i < 4; i++)
+				AddBorderPath(offsets[i - 1], offsets[i]);
+
+			return;
+		}
+
+		const auto Distance = [perimeter](int a, int b) -> int
+		{
+			const int diff = std::abs(a - b);
+			return std::min(diff, perimeter - diff);
+		};
+
+		std::vector<bool> used(exits.size());
+		for (const int offset : offsets)
+		{
+			size_t best = 0;
+			for (size_t i = 1; i < exits.size(); i++)
+			{
+				if (Distance(exits[i].m_offset, offset) < Distance(exits[best].m_offset, offset))
+					best = i;
+			}
+
+			const Exit& exit = exits[best];
+
+			// Exit is already there if the generator connected the room to the border on its own.
+			if (!used[best] && (generator.m_graph.m_path[exit.m_room] & (1 << exit.m_dir)) == 0)
+			{
+				const Point ent = generator.m_rooms[Graph::ToRoom(exit.m_room)].m_entrances[exit.m_dir];
+				const Point ext = GetBorderPoint(exit.m_offset);
+
+				output.m_entrances.emplace_back(ent);
+				output.m_paths.emplace_back(ext, Vec(ent.x - ext.x, ent.y - ext.y));
+			}
+
+			used[best] = true;
+			AddBorderPath(exit.m_offset, offset);
+		}
+	}
+
+	void World::AddBorderPath(int from, int to)
+	{
+		// Path goes the shorter way around the chunk and is split at the corners into straight segments.
+
+		const int w = GetWidth();
+		const int h = GetHeight();
+		const int perimeter = GetPerimeter();
+		const int corners[4] = { 0, w, w + h, w + h + w };
+
+		const int forward = (to - from + perimeter) % perimeter;
+		const bool clockwise = forward <= perimeter - forward;
+
+		int left = clockwise ? forward : perimeter - forward;
+		int crr = from;
+
+		while (left > 0)
+		{
+			int step = left;
+			for (const int corner : corners)
+			{
+				const int distance = clockwise ? (corner - crr + perimeter) % perimeter : (crr - corner + perimeter) % perimeter;
+				if (distance > 0 && distance < step)
+					step = distance;
+			}
+
+			const Point begin = GetBorderPoint(crr);
+			crr = clockwise ? (crr + step) % perimeter : (crr - step + perimeter) % perimeter;
+			const Point end = GetBorderPoint(crr);
+
+			m_generator.m_output->m_paths.emplace_back(begin, Vec(end.x - begin.x, end.y - begin.y));
+			left -= step;
+		}
+	}
+
+	Point World::GetBorderPoint(int offset) const
+	{
+		const int w = GetWidth();
+		const int h = GetHeight();
+
+		if (offset < w)
+			return Point(offset, 0);
+
+		if (offset < w + h)
+			return Point(w, offset - w);
+
+		if (offset < w + h + w)
+			return Point(w + h + w - offset, h);
+
+		return Point(0, w + h + w + h - offset);
+	}
+
+	int64_t World::GetChunkIndex(int64_t pos, int64_t size)
+	{
+		return pos >= 0 ? pos / size : -((-pos - 1) / size) - 1;
+	}
+
+	uint64_t World::Mix(uint64_t seed, int64_t x, int64_t y, uint64_t kind)
+	{
+		const uint64_t values[3] = { static_cast<uint64_t>(x), static_cast<uint64_t>(y), kind };
+
+		for (const uint64_t value : values)
+		{
+			uint64_t z = seed ^ (value + 0x9e3779b97f4a7c15);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			seed = z ^ (z >> 31);
+		}
+
+		return seed;
+	}
+}
+
+namespace dg
+{
+	World::World(const Input* input, std::size_t capacity)
+	{
+		if (input == nullptr)
+			throw std::runtime_error("Pointer to the dg::Input object was null");
+
+		m_world = new impl::World(*input, capacity);
+	}
+
+	World::~World() { delete m_world; }
+
+	World::World(World&& ref) noexcept : m_world(std::exchange(ref.m_world, nullptr)) {}
+
+	World& World::operator=(World&& ref) noexcept
+	{
+		if (&ref == this)
+			return *this;
+
+		delete m_world;
+		m_world = std::exchange(ref.m_world, nullptr);
+
+		return *this;
+	}
+
+	const Output& World::GetChunk(std::int64_t x, std::int64_t y)
+	{
+		if (m_world == nullptr)
+			throw std::runtime_error("World was moved from");
+
+		return m_world->GetChunk(x, y);
+	}
+
+	void World::GenerateChunk(std::int64_t x, std::int64_t y, Output* output)
+	{
+		if (m_world == nullptr)
+			throw std::runtime_error("World was moved from");
+
+		if (output == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output object was null");
+
+		m_world->GenerateChunk(x, y, *output);
+	}
+
+	void World::GenerateRegion(std::int64_t x, std::int64_t y, int width, int height, Output* output)
+	{
+		if (m_world == nullptr)
+			throw std::runtime_error("World was moved from");
+
+		if (output == nullptr)
+			throw std::runtime_error("Pointer to the dg::Output object was null");
+
+		m_world->GenerateRegion(x, y, width, height, *output);
+	}
+}
\ No newline at end of file
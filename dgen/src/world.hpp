@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023 Adrian Kulawik
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include "dgen_impl.hpp"
+
+#include <list>
+#include <unordered_map>
+
+namespace dg::impl
+{
+	struct World
+	{
+		// World is a grid of chunks, each generated from its own seed like a separate dungeon. Every edge between
+		// two chunks has a gate at a position derived only from the world seed and the edge, so both chunks know it
+		// without generating the other one. Chunk connects each of its gates to the nearest room touching its border
+		// by a path along the border, which is a cell boundary and never crosses rooms. The step across the edge
+		// belongs to the chunk on its western or northern side.
+
+		struct Chunk
+		{
+			int64_t m_x = 0;
+			int64_t m_y = 0;
+			Output m_output;
+		};
+
+		struct ChunkHash
+		{
+			size_t operator()(const std::pair<int64_t, int64_t>& key) const;
+		};
+
+		enum Edge : uint64_t { VERTICAL = 1, HORIZONTAL = 2 };
+
+		const Input m_input;
+		const size_t m_capacity;
+
+		Generator m_generator;
+		Input m_chunkInput;
+
+		std::list<Chunk> m_chunks;
+		std::unordered_map<std::pair<int64_t, int64_t>, std::list<Chunk>::iterator, ChunkHash> m_index;
+
+		World(const Input& input, size_t capacity);
+
+		const Output& GetChunk(int64_t x, int64_t y);
+		void GenerateChunk(int64_t x, int64_t y, Output& output);
+		void GenerateRegion(int64_t x, int64_t y, int w, int h, Output& output);
+		void ConnectGates(const int gates[4]);
+		void AddBorderPath(int from, int to);
+
+		int GetWidth() const { return m_input.m_width - 1; }
+		int GetHeight() const { return m_input.m_height - 1; }
+		int GetPerimeter() const { return (GetWidth() + GetHeight()) << 1; }
+		Point GetBorderPoint(int offset) const;
+
+		static uint64_t Mix(uint64_t seed, int64_t x, int64_t y, uint64_t kind);
+		static int64_t GetChunkIndex(int64_t pos, int64_t size);
+	};
+}
\ No newline at end of file